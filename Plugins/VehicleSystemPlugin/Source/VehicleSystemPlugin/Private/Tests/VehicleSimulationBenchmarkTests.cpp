@@ -0,0 +1,39 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleSimulationBenchmarkCommandlet.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Simulates every recorded golden file again with its settings and compares the final transforms (see UVehicleSimulationBenchmarkCommandlet)
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FAVS_BenchmarkGoldenTest, "VehicleSystemPlugin.Benchmark.Golden", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+void FAVS_BenchmarkGoldenTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	TArray<FString> GoldenFiles;
+	IFileManager::Get().FindFiles(GoldenFiles, *FPaths::GetPath(UVehicleSimulationBenchmarkCommandlet::GetGoldenPath(TEXT("Default"))), TEXT("csv"));
+	for( const FString& GoldenFile : GoldenFiles )
+	{
+		OutBeautifiedNames.Add(FPaths::GetBaseFilename(GoldenFile));
+		OutTestCommands.Add(FPaths::GetBaseFilename(GoldenFile));
+	}
+}
+
+bool FAVS_BenchmarkGoldenTest::RunTest(const FString& Parameters)
+{
+	const FString GoldenParams = UVehicleSimulationBenchmarkCommandlet::LoadGoldenParams(UVehicleSimulationBenchmarkCommandlet::GetGoldenPath(Parameters));
+	if( GoldenParams.IsEmpty() )
+	{
+		AddError(FString::Printf(TEXT("Golden %s has no recorded settings, record it again with -WriteGolden"), *Parameters));
+		return false;
+	}
+
+	TestTrue(TEXT("Final transforms match the golden data"), UVehicleSimulationBenchmarkCommandlet::Run(GoldenParams + TEXT(" -Golden=") + Parameters));
+	return true;
+}
+
+#endif
@@ -0,0 +1,164 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleWheelKernel.h"
+
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AVSWheelKernelTests
+{
+	constexpr float DeltaTime = 1.0f / 60.0f;
+	constexpr float Tolerance = 1.e-3f; // Relative to the expected value, absolute below 1
+
+	const FAVS_WheelKernel::EStream Outputs[] = { FAVS_WheelKernel::SlipX, FAVS_WheelKernel::SlipY, FAVS_WheelKernel::ForceX, FAVS_WheelKernel::ForceY,
+		FAVS_WheelKernel::ForceZ, FAVS_WheelKernel::CurrentSpringLength, FAVS_WheelKernel::AngularVelocity };
+
+	float GetError(float Value, float Expected)
+	{
+		return FMath::Abs(Value - Expected) / FMath::Max(1.0f, FMath::Abs(Expected)); // Relative for large forces
+	}
+
+	// Upright wheel on flat ground: 30 cm radius, 20 cm spring compressed to 10 cm, 50 N/mm spring without damping
+	int32 AddFlatWheel(FAVS_WheelKernel& Kernel, const FVector3f& Velocity)
+	{
+		const int32 Lane = Kernel.AddLane(Kernel.NumLanes);
+		for( int32 Stream = 0; Stream < FAVS_WheelKernel::SlipX; ++Stream ) { Kernel.Get(FAVS_WheelKernel::EStream(Stream), Lane) = 0.0f; }
+		Kernel.Get(FAVS_WheelKernel::NormalZ, Lane) = 1.0f;
+		Kernel.Get(FAVS_WheelKernel::ForwardX, Lane) = 1.0f;
+		Kernel.Get(FAVS_WheelKernel::RightY, Lane) = 1.0f;
+		Kernel.Get(FAVS_WheelKernel::UpZ, Lane) = 1.0f;
+		Kernel.Get(FAVS_WheelKernel::VelocityX, Lane) = Velocity.X;
+		Kernel.Get(FAVS_WheelKernel::VelocityY, Lane) = Velocity.Y;
+		Kernel.Get(FAVS_WheelKernel::VelocityZ, Lane) = Velocity.Z;
+		Kernel.Get(FAVS_WheelKernel::TraceDistance, Lane) = 70.0f;
+		Kernel.Get(FAVS_WheelKernel::Radius, Lane) = 30.0f;
+		Kernel.Get(FAVS_WheelKernel::RadiusM, Lane) = 0.3f;
+		Kernel.Get(FAVS_WheelKernel::SpringLength, Lane) = 20.0f;
+		Kernel.Get(FAVS_WheelKernel::SpringStrength, Lane) = 50.0f;
+		Kernel.Get(FAVS_WheelKernel::Inertia, Lane) = 1.0f;
+		Kernel.Get(FAVS_WheelKernel::FrictionX, Lane) = 1.0f;
+		Kernel.Get(FAVS_WheelKernel::FrictionY, Lane) = 1.0f;
+		Kernel.Get(FAVS_WheelKernel::BrakeTorque, Lane) = 1000.0f;
+		Kernel.Get(FAVS_WheelKernel::RollingResistance, Lane) = 0.01f;
+		Kernel.Get(FAVS_WheelKernel::AntiGravity, Lane) = 980.0f * 1500.0f * 0.01f;
+		Kernel.Get(FAVS_WheelKernel::SlipX, Lane) = 0.0f;
+		Kernel.Get(FAVS_WheelKernel::SlipY, Lane) = 0.0f;
+		return Lane;
+	}
+
+	// Wheel with every input random, steep and over compressed contacts included
+	void AddRandomWheel(FAVS_WheelKernel& Kernel, FRandomStream& Random)
+	{
+		const int32 Lane = Kernel.AddLane(Kernel.NumLanes);
+		const FVector3f Normal = FVector3f(Random.VRand() * 0.3f + FVector(0.0f, 0.0f, 1.0f)).GetSafeNormal();
+		const FQuat4f Rotation = FQuat4f(FRotator3f(Random.FRandRange(-20.0f, 20.0f), Random.FRandRange(-180.0f, 180.0f), Random.FRandRange(-20.0f, 20.0f)));
+		const FVector3f Forward = Rotation.GetAxisX(), Right = Rotation.GetAxisY(), Up = Rotation.GetAxisZ();
+		const FVector3f Velocity = FVector3f(Random.VRand()) * Random.FRandRange(0.0f, 4000.0f);
+
+		Kernel.Get(FAVS_WheelKernel::NormalX, Lane) = Normal.X; Kernel.Get(FAVS_WheelKernel::NormalY, Lane) = Normal.Y; Kernel.Get(FAVS_WheelKernel::NormalZ, Lane) = Normal.Z;
+		Kernel.Get(FAVS_WheelKernel::ForwardX, Lane) = Forward.X; Kernel.Get(FAVS_WheelKernel::ForwardY, Lane) = Forward.Y; Kernel.Get(FAVS_WheelKernel::ForwardZ, Lane) = Forward.Z;
+		Kernel.Get(FAVS_WheelKernel::RightX, Lane) = Right.X; Kernel.Get(FAVS_WheelKernel::RightY, Lane) = Right.Y; Kernel.Get(FAVS_WheelKernel::RightZ, Lane) = Right.Z;
+		Kernel.Get(FAVS_WheelKernel::UpX, Lane) = Up.X; Kernel.Get(FAVS_WheelKernel::UpY, Lane) = Up.Y; Kernel.Get(FAVS_WheelKernel::UpZ, Lane) = Up.Z;
+		Kernel.Get(FAVS_WheelKernel::VelocityX, Lane) = Velocity.X; Kernel.Get(FAVS_WheelKernel::VelocityY, Lane) = Velocity.Y; Kernel.Get(FAVS_WheelKernel::VelocityZ, Lane) = Velocity.Z;
+		Kernel.Get(FAVS_WheelKernel::Radius, Lane) = Random.FRandRange(20.0f, 50.0f);
+		Kernel.Get(FAVS_WheelKernel::RadiusM, Lane) = Kernel.Get(FAVS_WheelKernel::Radius, Lane) * 0.01f;
+		Kernel.Get(FAVS_WheelKernel::SpringLength, Lane) = Random.FRandRange(10.0f, 40.0f);
+		Kernel.Get(FAVS_WheelKernel::TraceDistance, Lane) = Random.FRandRange(0.0f, 2.0f * Kernel.Get(FAVS_WheelKernel::Radius, Lane) + Kernel.Get(FAVS_WheelKernel::SpringLength, Lane));
+		Kernel.Get(FAVS_WheelKernel::SpringStrength, Lane) = Random.FRandRange(20.0f, 200.0f);
+		Kernel.Get(FAVS_WheelKernel::SpringDamping, Lane) = Random.FRandRange(1.0f, 10.0f);
+		Kernel.Get(FAVS_WheelKernel::Inertia, Lane) = Random.FRandRange(0.5f, 5.0f);
+		Kernel.Get(FAVS_WheelKernel::FrictionX, Lane) = Random.FRandRange(0.5f, 2.0f);
+		Kernel.Get(FAVS_WheelKernel::FrictionY, Lane) = Random.FRandRange(0.5f, 2.0f);
+		Kernel.Get(FAVS_WheelKernel::BrakeTorque, Lane) = Random.FRandRange(500.0f, 3000.0f);
+		Kernel.Get(FAVS_WheelKernel::RollingResistance, Lane) = Random.FRandRange(0.0f, 0.05f);
+		Kernel.Get(FAVS_WheelKernel::BrakeInput, Lane) = Random.FRand() < 0.3f ? Random.FRand() : 0.0f;
+		Kernel.Get(FAVS_WheelKernel::DriveTorque, Lane) = Random.FRand() < 0.5f ? Random.FRandRange(-800.0f, 800.0f) : 0.0f;
+		Kernel.Get(FAVS_WheelKernel::Locked, Lane) = Random.FRand() < 0.1f ? 1.0f : 0.0f;
+		Kernel.Get(FAVS_WheelKernel::AntiGravity, Lane) = 980.0f * 1500.0f * 0.01f;
+		Kernel.Get(FAVS_WheelKernel::SlipX, Lane) = Random.FRandRange(-2.0f, 2.0f);
+		Kernel.Get(FAVS_WheelKernel::SlipY, Lane) = Random.FRandRange(-2.0f, 2.0f);
+	}
+}
+
+// Hand computed results of the per wheel math the kernel replaced, checked on both paths
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAVS_WheelKernelFixedCasesTest, "VehicleSystemPlugin.WheelKernel.FixedCases", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FAVS_WheelKernelFixedCasesTest::RunTest(const FString& Parameters)
+{
+	using namespace AVSWheelKernelTests;
+
+	struct FCase
+	{
+		const TCHAR* Name;
+		float Expected[UE_ARRAY_COUNT(Outputs)]; // SlipX, SlipY, ForceX, ForceY, ForceZ, CurrentSpringLength, AngularVelocity
+	};
+
+	// Spring force is 50 N/mm * 100 mm = 5000 N, forces are in cN
+	FAVS_WheelKernel Kernel;
+	TArray<FCase> Cases;
+
+	// At rest, the spring holds the wheel up and there is no traction
+	AddFlatWheel(Kernel, FVector3f::ZeroVector);
+	Cases.Add({ TEXT("Resting"), { 0.0f, 0.0f, 0.0f, 0.0f, 500000.0f, 10.0f, 0.0f } });
+
+	// 10 m/s forward with 100 Nm: slip target (10000 Nm drive - 10 Nm rolling resistance) / 1500 Nm friction torque, reached in one step and normalized
+	int32 Lane = AddFlatWheel(Kernel, FVector3f(1000.0f, 0.0f, 0.0f));
+	Kernel.Get(FAVS_WheelKernel::DriveTorque, Lane) = 100.0f;
+	Cases.Add({ TEXT("Driving"), { 9990.0f / 1500.0f, 0.0f, 500000.0f, 0.0f, 500000.0f, 10.0f, 1000.0f / 30.0f } });
+
+	// Locked wheel sliding sideways at 5 m/s: 90 degree slip angle, lateral slip -90 / 12 normalized to -1
+	Lane = AddFlatWheel(Kernel, FVector3f(0.0f, 500.0f, 0.0f));
+	Kernel.Get(FAVS_WheelKernel::Locked, Lane) = 1.0f;
+	Cases.Add({ TEXT("Locked sliding"), { 0.0f, -7.5f, 0.0f, -500000.0f, 500000.0f, 10.0f, 0.0f } });
+
+	FAVS_WheelKernel Vectorized = Kernel;
+	Kernel.SolveScalar(DeltaTime);
+	Vectorized.SolveVectorized(DeltaTime);
+
+	for( int32 CaseIndex = 0; CaseIndex < Cases.Num(); ++CaseIndex )
+	{
+		const FCase& Case = Cases[CaseIndex];
+		for( int32 OutputIndex = 0; OutputIndex < UE_ARRAY_COUNT(Outputs); ++OutputIndex )
+		{
+			const FAVS_WheelKernel::EStream Output = Outputs[OutputIndex];
+			const float Expected = Case.Expected[OutputIndex];
+			TestTrue(FString::Printf(TEXT("%s scalar stream %d: %g, expected %g"), Case.Name, (int32)Output, Kernel.Get(Output, CaseIndex), Expected),
+				GetError(Kernel.Get(Output, CaseIndex), Expected) < Tolerance);
+			TestTrue(FString::Printf(TEXT("%s SIMD stream %d: %g, expected %g"), Case.Name, (int32)Output, Vectorized.Get(Output, CaseIndex), Expected),
+				GetError(Vectorized.Get(Output, CaseIndex), Expected) < Tolerance);
+		}
+	}
+	return true;
+}
+
+// Solves the same random wheels with both paths
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAVS_WheelKernelSIMDTest, "VehicleSystemPlugin.WheelKernel.SIMDMatchesScalar", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+bool FAVS_WheelKernelSIMDTest::RunTest(const FString& Parameters)
+{
+	using namespace AVSWheelKernelTests;
+
+	constexpr int32 NumWheels = 1023; // Not a multiple of the lane width so padding is covered
+	FRandomStream Random(0x41565321);
+
+	FAVS_WheelKernel Kernel;
+	for( int32 WIndex = 0; WIndex < NumWheels; ++WIndex ) { AddRandomWheel(Kernel, Random); }
+
+	FAVS_WheelKernel Reference = Kernel;
+	Reference.SolveScalar(DeltaTime);
+	Kernel.SolveVectorized(DeltaTime);
+
+	for( const FAVS_WheelKernel::EStream Output : Outputs )
+	{
+		float MaxError = 0.0f;
+		for( int32 Lane = 0; Lane < NumWheels; ++Lane )
+		{
+			MaxError = FMath::Max(MaxError, GetError(Kernel.Get(Output, Lane), Reference.Get(Output, Lane)));
+		}
+		TestTrue(FString::Printf(TEXT("Stream %d max error %g"), (int32)Output, MaxError), MaxError < Tolerance);
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleForces.h"
+
+#include "VehicleSystemFunctions.h"
+
+void FAVS_VehicleForces::Reset()
+{
+	Bodies.Reset();
+	Brakes.Reset();
+}
+
+FAVS_VehicleForces::FBodyForces& FAVS_VehicleForces::GetBody(Chaos::FRigidBodyHandle_Internal* Target)
+{
+	for( FBodyForces& Body : Bodies )
+	{
+		if( Body.Target == Target ) return Body;
+	}
+
+	FBodyForces& Body = Bodies.AddDefaulted_GetRef();
+	Body.Target = Target;
+	Body.CenterOfMass = UVehicleSystemFunctions::AVS_ChaosGetCenterOfMass(Target);
+	return Body;
+}
+
+void FAVS_VehicleForces::AddForceAtLocation(Chaos::FRigidBodyHandle_Internal* Target, const FVector& Location, const FVector& Force)
+{
+	FBodyForces& Body = GetBody(Target);
+	Body.Force += Force;
+	Body.Torque += FVector::CrossProduct(Location - Body.CenterOfMass, Force); // Relative to the center of mass, stays precise far from the origin
+}
+
+void FAVS_VehicleForces::AddForce(Chaos::FRigidBodyHandle_Internal* Target, const FVector& Force)
+{
+	GetBody(Target).Force += Force;
+}
+
+void FAVS_VehicleForces::AddBrakes(Chaos::FRigidBodyHandle_Internal* Target, float BrakeTorque, float DeltaTime)
+{
+	Brakes.Add({ Target, BrakeTorque, DeltaTime });
+}
+
+int32 FAVS_VehicleForces::Apply()
+{
+	const int32 NumWrites = Bodies.Num() + Brakes.Num();
+	for( const FBodyForces& Body : Bodies )
+	{
+		UVehicleSystemFunctions::AVS_ChaosAddAccumulatedForce(Body.Target, Body.Force, Body.Torque);
+	}
+	for( const FBrakes& Brake : Brakes )
+	{
+		UVehicleSystemFunctions::AVS_ChaosBrakes(Brake.Target, Brake.BrakeTorque, Brake.DeltaTime);
+	}
+	Reset();
+	return NumWrites;
+}
+
+void FAVS_VehicleForces::GetBodyForces(const Chaos::FRigidBodyHandle_Internal* Target, FVector& OutForce, FVector& OutTorque) const
+{
+	OutForce = FVector::ZeroVector;
+	OutTorque = FVector::ZeroVector;
+	for( const FBodyForces& Body : Bodies )
+	{
+		if( Body.Target != Target ) continue;
+		OutForce = Body.Force;
+		OutTorque = Body.Torque;
+		return;
+	}
+}
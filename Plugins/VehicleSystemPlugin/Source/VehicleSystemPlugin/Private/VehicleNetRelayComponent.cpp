@@ -0,0 +1,32 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleNetRelayComponent.h"
+
+UVehicleNetRelayComponent::UVehicleNetRelayComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UVehicleNetRelayComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Replicated copy of the owning client, the server starts relaying once it knows
+	if( GetNetMode() == NM_Client ) Server_NotifyClientReady();
+}
+
+void UVehicleNetRelayComponent::Server_NotifyClientReady_Implementation()
+{
+	bClientReady = true;
+}
+
+void UVehicleNetRelayComponent::Client_ReceiveNetStates_Implementation(const TArray<FAVS_NetStateRelayEntry>& States)
+{
+	for( const FAVS_NetStateRelayEntry& Entry : States )
+	{
+		// Vehicles that are not relevant to us yet resolve to null
+		if( IsValid(Entry.Vehicle) ) Entry.Vehicle->ReceiveNetState(Entry.State);
+	}
+}
@@ -5,43 +5,494 @@
 
 #include "PBDRigidsSolver.h"
 #include "VehicleSystemBase.h"
+#include "VehicleSystemStats.h"
 #include "Chaos/ContactModification.h"
+#include "Chaos/ParticleUtilities.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarAVSParallelVehicles(
+	TEXT("avs.Physics.ParallelVehicles"),
+	0,
+	TEXT("Trace and tick vehicles on worker threads once at least this many are simulated, 0 keeps every vehicle on the physics thread"));
+
+void FVehiclePhysicsVehicleState::UpdateHandleCache(const FVehiclePhysicsVehicleInput& VehicleInput)
+{
+	if( CachedVehicleProxy == VehicleInput.VehicleProxy && CachedColdWheels == VehicleInput.ColdWheels ) return;
+
+	CachedVehicleProxy = VehicleInput.VehicleProxy;
+	CachedColdWheels = VehicleInput.ColdWheels;
+	BodyHandle = CachedVehicleProxy ? CachedVehicleProxy->GetPhysicsThreadAPI() : nullptr;
+
+	WheelHandles.Reset();
+	if( !CachedColdWheels.IsValid() ) return;
+
+	for( const FAVS_WheelColdData& ColdWheel : CachedColdWheels->Wheels )
+	{
+		WheelHandles.Add(ColdWheel.WheelProxy ? ColdWheel.WheelProxy->GetPhysicsThreadAPI() : nullptr);
+	}
+}
+
+bool FVehiclePhysicsVehicleState::UpdateDormancy(const FVehiclePhysicsVehicleInput& VehicleInput, float DeltaTime)
+{
+	using namespace Chaos;
+
+	const bool bDormancyEnabled = VehicleInput.DormancyDelay > 0.0f;
+	const EObjectStateType ObjectState = BodyHandle->ObjectState();
+
+	if( bDormant )
+	{
+		// Chaos wakes the sleeping body on contact, the game thread wakes it with input
+		if( bDormancyEnabled && !VehicleInput.bDormancyWake && ObjectState == EObjectStateType::Sleeping ) return true;
+
+		if( ObjectState == EObjectStateType::Sleeping ) SetBodiesObjectState(EObjectStateType::Dynamic);
+		bDormant = false;
+		RestTime = 0.0f;
+		return false;
+	}
+
+	if( !bDormancyEnabled || ObjectState != EObjectStateType::Dynamic )
+	{
+		RestTime = 0.0f;
+		return false;
+	}
+
+	const float Speed = BodyHandle->V().Size();
+	const float AngularSpeed = FMath::RadiansToDegrees(BodyHandle->W().Size());
+	if( VehicleInput.bDormancyWake || Speed > VehicleInput.DormancyWakeSpeed || AngularSpeed > VehicleInput.DormancyWakeAngularSpeed )
+	{
+		RestTime = 0.0f;
+	}
+	else if( Speed <= VehicleInput.DormancySleepSpeed && AngularSpeed <= VehicleInput.DormancySleepAngularSpeed )
+	{
+		RestTime += DeltaTime;
+	}
+
+	if( RestTime < VehicleInput.DormancyDelay ) return false;
+
+	SetBodiesObjectState(EObjectStateType::Sleeping);
+	bDormant = true;
+	RestTime = 0.0f;
+	return true;
+}
+
+void FVehiclePhysicsVehicleState::SetBodiesObjectState(Chaos::EObjectStateType ObjectState)
+{
+	BodyHandle->SetObjectState(ObjectState);
+	for( Chaos::FRigidBodyHandle_Internal* WheelHandle : WheelHandles )
+	{
+		if( WheelHandle != nullptr && WheelHandle->ObjectState() != Chaos::EObjectStateType::Kinematic ) WheelHandle->SetObjectState(ObjectState);
+	}
+}
+
+void FVehiclePhysicsVehicleState::StepInputFrame(const FVehiclePhysicsVehicleInput& VehicleInput, float DeltaTime)
+{
+	// The previous frame ends with the body state this substep starts from
+	if( bInputFrameStepped && InputRecords.Num() > 0 )
+	{
+		FVehiclePhysicsInputRecord& Record = InputRecords.Last();
+		Record.Position = BodyHandle->X();
+		Record.Rotation = BodyHandle->R();
+		Record.Velocity = BodyHandle->V();
+		Record.AngularVelocity = BodyHandle->W();
+		Record.bComplete = true;
+	}
+	bInputFrameStepped = false;
+
+	if( VehicleInput.InputFrameMode != EVehicleInputFrames::Replay )
+	{
+		Inputs = VehicleInput.VehicleInputs;
+		if( VehicleInput.InputFrameMode == EVehicleInputFrames::None ) return;
+		++InputFrame;
+	}
+	else
+	{
+		if( InputFrameEpoch != VehicleInput.InputFrameEpoch ) // Owner changed, its frames are unrelated
+		{
+			InputFrameEpoch = VehicleInput.InputFrameEpoch;
+			PendingInputFrames.Reset();
+			InputRecords.Reset();
+			LastQueuedInputFrame = 0;
+			InputFrame = 0;
+		}
+
+		// The same input can be consumed by several substeps, frames are only queued once
+		for( const FAVS_InputFrame& Frame : VehicleInput.InputFrames )
+		{
+			if( Frame.Frame <= LastQueuedInputFrame ) continue;
+			PendingInputFrames.Add(Frame);
+			LastQueuedInputFrame = Frame.Frame;
+		}
+
+		// Owner ran this far ahead of the server, the oldest frames are dropped rather than adding latency forever
+		constexpr int32 MaxPendingInputFrames = 128;
+		if( PendingInputFrames.Num() > MaxPendingInputFrames ) PendingInputFrames.RemoveAt(0, PendingInputFrames.Num() - MaxPendingInputFrames, EAllowShrinking::No);
+
+		// Starved, the last inputs are simulated again without a frame. The owner is corrected for the difference
+		if( PendingInputFrames.Num() == 0 ) return;
+
+		Inputs = PendingInputFrames[0].Inputs;
+		InputFrame = PendingInputFrames[0].Frame;
+		PendingInputFrames.RemoveAt(0, 1, EAllowShrinking::No);
+	}
+
+	// Predicted frames are kept until the server can no longer correct them, the server only reports the last few
+	const int32 MaxInputRecords = VehicleInput.InputFrameMode == EVehicleInputFrames::Predict ? FMath::Max(VehicleInput.InputHistorySize, MaxOutputInputRecords) : MaxOutputInputRecords;
+	if( InputRecords.Num() >= MaxInputRecords ) InputRecords.RemoveAt(0, InputRecords.Num() - MaxInputRecords + 1, EAllowShrinking::No);
+	FVehiclePhysicsInputRecord& Record = InputRecords.AddDefaulted_GetRef();
+	Record.Frame = InputFrame;
+	Record.Inputs = Inputs;
+	Record.DeltaTime = DeltaTime;
+	bInputFrameStepped = true;
+}
+
+void FVehiclePhysicsVehicleState::WriteInputFrames(FVehiclePhysicsVehicleOutput& VehicleOutput) const
+{
+	VehicleOutput.InputFrameEpoch = InputFrameEpoch;
+	VehicleOutput.LastQueuedInputFrame = LastQueuedInputFrame;
+	VehicleOutput.CorrectionId = CorrectionId;
+
+	const int32 FirstRecord = FMath::Max(InputRecords.Num() - MaxOutputInputRecords, 0);
+	VehicleOutput.InputRecords.Reset();
+	VehicleOutput.InputRecords.Append(InputRecords.GetData() + FirstRecord, InputRecords.Num() - FirstRecord);
+}
+
+void FVehiclePhysicsVehicleState::IntegrateBody(float DeltaTime, float GravityZ)
+{
+	using namespace Chaos;
+
+	FVector Force, Torque;
+	Forces.GetBodyForces(BodyHandle, Force, Torque);
+	Forces.Reset();
+
+	// Semi-implicit Euler around the center of mass, like the solver integrates the body before its constraints
+	const FVec3 CenterOfMass = FParticleUtilitiesXR::GetCoMWorldPosition(BodyHandle);
+	const FVec3 Velocity = BodyHandle->V() + (Force * BodyHandle->InvM() + FVec3(0.0, 0.0, GravityZ)) * DeltaTime;
+	const FVec3 AngularVelocity = BodyHandle->W() + FParticleUtilitiesXR::GetWorldInvInertia(BodyHandle) * Torque * DeltaTime;
+	const FRotation3 Rotation = FRotation3::IntegrateRotationWithAngularVelocity(BodyHandle->R(), AngularVelocity, DeltaTime);
+
+	BodyHandle->SetV(Velocity);
+	BodyHandle->SetW(AngularVelocity);
+	BodyHandle->SetR(Rotation);
+	BodyHandle->SetX(CenterOfMass + Velocity * DeltaTime - Rotation.RotateVector(BodyHandle->CenterOfMass()));
+}
+
+void FVehiclePhysicsVehicleState::SetBodyState(const FVehiclePhysicsInputRecord& Record)
+{
+	BodyHandle->SetX(Record.Position);
+	BodyHandle->SetR(Chaos::FRotation3(Record.Rotation));
+	BodyHandle->SetV(Record.Velocity);
+	BodyHandle->SetW(Record.AngularVelocity);
+}
+
+FVehiclePhysicsVehicleState& FVehiclePhysicsCallback::GetVehicleState(int32 VehicleId, uint32 VehicleSerial)
+{
+	if( !VehicleStates.IsValidIndex(VehicleId) ) { VehicleStates.SetNum(VehicleId + 1); }
+
+	FVehiclePhysicsVehicleState& VehicleState = VehicleStates[VehicleId];
+	if( VehicleState.VehicleSerial != VehicleSerial ) // Slot was reused by another vehicle, start fresh
+	{
+		VehicleState = FVehiclePhysicsVehicleState();
+		VehicleState.VehicleSerial = VehicleSerial;
+	}
+	return VehicleState;
+}
 
 void FVehiclePhysicsCallback::OnPreSimulate_Internal()
 {
 	using namespace Chaos;
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_PreSimulate);
 
+	const uint64 StartCycles = FPlatformTime::Cycles64();
 	float ChaosDeltaTime = GetDeltaTime_Internal();
-
-	FVehiclePhysicsPhysicsOutput& NewOutput = GetProducerOutputData_Internal();
-	NewOutput.ChaosDeltaTime = ChaosDeltaTime;
 	
 	const FVehiclePhysicsPhysicsInput* Input = GetConsumerInput_Internal();
-	if (Input == nullptr || Input->VehicleMeshPrim == nullptr )
+	if (Input == nullptr)
 		return;
 	
 	Chaos::FPhysicsSolver* PhysicsSolver = static_cast<Chaos::FPhysicsSolver*>(GetSolver());
 	if (PhysicsSolver == nullptr)
 		return;
 
-	FPhysicsActorHandle ActorHandle = Input->VehicleMeshPrim->GetBodyInstance()->GetPhysicsActorHandle();
-	if(ActorHandle == nullptr)
+	UWorld* World = Input->World.Get(); // only safe to access for scene queries
+	if( World == nullptr )
 		return;
-	
-	Chaos::FRigidBodyHandle_Internal* PhysicsHandle = ActorHandle->GetPhysicsThreadAPI();
-	if(PhysicsHandle != nullptr)
+
+	DisabledContacts.Reset();
+	SimulatedVehicles.Reset();
+	DormantVehicles.Reset();
+	WheelQueries.Reset();
+	WheelKernel.Reset();
+
+	// Gather the wheel rays of every dynamic vehicle
+	for( int32 InputIndex = 0; InputIndex < Input->NumVehicles; ++InputIndex )
 	{
-		Chaos::EObjectStateType PhysicsState = PhysicsHandle->ObjectState();
-		if( PhysicsState == Chaos::EObjectStateType::Dynamic )
+		const FVehiclePhysicsVehicleInput& VehicleInput = Input->Vehicles[InputIndex];
+
+		if( VehicleInput.VehicleProxy != nullptr )
 		{
-			AVehicleSystemBase* MyVehicle = Cast<AVehicleSystemBase>(Input->VehicleActor);
-			if(MyVehicle != nullptr)
+			for( const Chaos::FSingleParticlePhysicsProxy* WheelMesh : VehicleInput.ContactModProxies )
 			{
-				//MyVehicle->AVS_PhysicsTickBP(ChaosDeltaTime); // Physics Thread in Blueprint
-				MyVehicle->AVS_PhysicsTick(ChaosDeltaTime, Input, NewOutput);
+				DisabledContacts.Add(FVehicleContactPair(VehicleInput.VehicleProxy, WheelMesh));
 			}
 		}
+		if( VehicleInput.bContactsOnly ) continue;
+
+		if( VehicleInput.VehicleProxy == nullptr || !VehicleInput.ColdWheels.IsValid() || VehicleInput.ColdWheels->Wheels.Num() != VehicleInput.Wheels.Num() )
+			continue;
+
+		FVehiclePhysicsVehicleState& VehicleState = GetVehicleState(VehicleInput.VehicleId, VehicleInput.VehicleSerial);
+		VehicleState.UpdateHandleCache(VehicleInput);
+		VehicleState.Telemetry.Reset();
+		VehicleState.bTelemetry = AVS_TELEMETRY && Input->bTelemetry && TelemetryRing.IsInitialized();
+		VehicleState.SurfaceFrictions = Input->SurfaceFrictions.Get();
+
+		Chaos::FRigidBodyHandle_Internal* PhysicsHandle = VehicleState.BodyHandle;
+		if(PhysicsHandle == nullptr)
+			continue;
+
+		if( VehicleState.UpdateDormancy(VehicleInput, ChaosDeltaTime) )
+		{
+			DormantVehicles.Add(InputIndex); // No traces or forces until it wakes
+			continue;
+		}
+
+		if(PhysicsHandle->ObjectState() != Chaos::EObjectStateType::Dynamic)
+			continue;
+
+		if( VehicleInput.InputFrameMode == EVehicleInputFrames::Predict && VehicleInput.CorrectionId != VehicleState.CorrectionId ) ReplayCorrection(World, VehicleInput, VehicleState);
+		VehicleState.StepInputFrame(VehicleInput, ChaosDeltaTime);
+		AVehicleSystemBase::AVS_GatherWheelQueries(VehicleInput, VehicleState, WheelQueries);
+		SimulatedVehicles.Add(InputIndex);
+	}
+
+	// Vehicles only read their own state and record their forces, so they can be ticked on worker threads
+	const int32 MinParallelVehicles = CVarAVSParallelVehicles.GetValueOnAnyThread();
+	const bool bParallel = MinParallelVehicles > 0 && SimulatedVehicles.Num() >= MinParallelVehicles;
+
+	// One pass over the physics scene for every wheel
+	{
+		AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_WheelTraces);
+		WheelQueries.Resolve(World, bParallel);
+	}
+	AVS_COUNTER_ADD(Traces, WheelQueries.Num());
+	AVS_COUNTER_ADD(VehiclesSimulated, SimulatedVehicles.Num());
+
+	// Output snapshot is reused, only the latest one is read by the game thread
+	FVehiclePhysicsOutputSnapshot& NewOutput = OutputBuffer.GetWriteBuffer();
+	NewOutput.Reset();
+	NewOutput.ChaosDeltaTime = ChaosDeltaTime;
+	for( const int32 InputIndex : SimulatedVehicles )
+	{
+		const FVehiclePhysicsVehicleInput& VehicleInput = Input->Vehicles[InputIndex];
+		FVehiclePhysicsVehicleOutput& VehicleOutput = NewOutput.AddVehicle(VehicleInput.VehicleId, VehicleInput.VehicleSerial);
+		if( VehicleInput.InputFrameMode != EVehicleInputFrames::None ) VehicleStates[VehicleInput.VehicleId].WriteInputFrames(VehicleOutput);
+	}
+	for( const int32 InputIndex : DormantVehicles ) // After the simulated vehicles so their outputs keep the same index
+	{
+		const FVehiclePhysicsVehicleInput& VehicleInput = Input->Vehicles[InputIndex];
+		FVehiclePhysicsVehicleOutput& VehicleOutput = NewOutput.AddVehicle(VehicleInput.VehicleId, VehicleInput.VehicleSerial);
+		VehicleOutput.bDormant = true;
+		if( VehicleInput.InputFrameMode != EVehicleInputFrames::None ) VehicleStates[VehicleInput.VehicleId].WriteInputFrames(VehicleOutput);
+	}
+
+	if( bParallel )
+	{
+		// Each vehicle solves its raycast wheels in its own kernel
+		ParallelFor(SimulatedVehicles.Num(), [&](int32 SimIndex)
+		{
+			const FVehiclePhysicsVehicleInput& VehicleInput = Input->Vehicles[SimulatedVehicles[SimIndex]];
+			FVehiclePhysicsVehicleState& VehicleState = VehicleStates[VehicleInput.VehicleId];
+			FVehiclePhysicsVehicleOutput& VehicleOutput = NewOutput.Vehicles[SimIndex];
+
+			VehicleState.WheelKernel.Reset();
+			AVehicleSystemBase::AVS_PhysicsTick(ChaosDeltaTime, World, VehicleInput, VehicleState, WheelQueries, VehicleState.WheelKernel, VehicleOutput);
+			VehicleState.WheelKernel.Solve(ChaosDeltaTime);
+			AVehicleSystemBase::AVS_ApplyWheelKernel(VehicleInput, VehicleState, VehicleState.WheelKernel, VehicleOutput);
+		});
+	}
+	else
+	{
+		// Tick vehicles together
+		for( int32 SimIndex = 0; SimIndex < SimulatedVehicles.Num(); ++SimIndex )
+		{
+			const FVehiclePhysicsVehicleInput& VehicleInput = Input->Vehicles[SimulatedVehicles[SimIndex]];
+			AVehicleSystemBase::AVS_PhysicsTick(ChaosDeltaTime, World, VehicleInput, VehicleStates[VehicleInput.VehicleId], WheelQueries, WheelKernel, NewOutput.Vehicles[SimIndex]);
+		}
+
+		// Raycast wheels of every vehicle in one pass, then apply the results per vehicle
+		WheelKernel.Solve(ChaosDeltaTime);
+		for( int32 SimIndex = 0; SimIndex < SimulatedVehicles.Num(); ++SimIndex )
+		{
+			const FVehiclePhysicsVehicleInput& VehicleInput = Input->Vehicles[SimulatedVehicles[SimIndex]];
+			AVehicleSystemBase::AVS_ApplyWheelKernel(VehicleInput, VehicleStates[VehicleInput.VehicleId], WheelKernel, NewOutput.Vehicles[SimIndex]);
+		}
+	}
+
+	// Handle writes stay on the physics thread
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_ApplyForces);
+	int32 NumForces = 0;
+	int32 NumWheels = 0;
+	for( int32 SimIndex = 0; SimIndex < SimulatedVehicles.Num(); ++SimIndex )
+	{
+		const FVehiclePhysicsVehicleInput& VehicleInput = Input->Vehicles[SimulatedVehicles[SimIndex]];
+		FVehiclePhysicsVehicleState& VehicleState = VehicleStates[VehicleInput.VehicleId];
+		NumForces += VehicleState.Forces.Apply();
+		NumWheels += VehicleInput.Wheels.Num();
+
+		#if AVS_TELEMETRY
+		if( VehicleState.bTelemetry ) PushTelemetry(VehicleInput, VehicleState, NewOutput.Vehicles[SimIndex]);
+		#endif
+	}
+	++TelemetrySubstep;
+	AVS_COUNTER_ADD(ForcesApplied, NumForces);
+	AVS_COUNTER_ADD(WheelsSimulated, NumWheels);
+
+	NewOutput.SimulateCycles = FPlatformTime::Cycles64() - StartCycles;
+	OutputBuffer.SwapWriteBuffers(); // Publish
+
+	// The triple buffer skips steps, tools timing every substep read them from the ring
+	if( Input->bSubstepTimes && TelemetryRing.IsInitialized() )
+	{
+		FAVS_TelemetryRecord Record;
+		Record.Type = EAVS_TelemetryType::Substep;
+		Record.Substep = TelemetrySubstep - 1;
+		Record.SimulateMs = static_cast<float>(FPlatformTime::ToMilliseconds64(NewOutput.SimulateCycles));
+		TelemetryRing.Push(Record);
+	}
+}
+
+void FVehiclePhysicsCallback::ReplayCorrection(const UWorld* World, const FVehiclePhysicsVehicleInput& VehicleInput, FVehiclePhysicsVehicleState& VehicleState)
+{
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_Replay);
+	VehicleState.CorrectionId = VehicleInput.CorrectionId; // Handled once, even when the frame is no longer known
+
+	const FVehiclePhysicsInputRecord& Correction = VehicleInput.Correction;
+	TArray<FVehiclePhysicsInputRecord>& Records = VehicleState.InputRecords;
+	const int32 CorrectedIndex = Records.IndexOfByPredicate([&Correction](const FVehiclePhysicsInputRecord& Record) { return Record.Frame == Correction.Frame; });
+	if( CorrectedIndex == INDEX_NONE ) return; // Older than the history
+
+	// The last frame ends with the current body state, its record is completed by the next StepInputFrame
+	FVehiclePhysicsInputRecord& Corrected = Records[CorrectedIndex];
+	Chaos::FRigidBodyHandle_Internal* BodyHandle = VehicleState.BodyHandle;
+	if( !Corrected.bComplete )
+	{
+		Corrected.Position = BodyHandle->X();
+		Corrected.Rotation = BodyHandle->R();
+		Corrected.Velocity = BodyHandle->V();
+		Corrected.AngularVelocity = BodyHandle->W();
+	}
+
+	// Physics wheels are bodies of their own, the vehicle can't be stepped without the solver.
+	// The motion predicted since the corrected frame is re-based on the server state instead
+	if( VehicleState.WheelHandles.ContainsByPredicate([](const Chaos::FRigidBodyHandle_Internal* WheelHandle) { return WheelHandle != nullptr; }) )
+	{
+		const FVehiclePhysicsInputRecord Predicted = Corrected;
+		const FQuat RotationCorrection = Correction.Rotation * Predicted.Rotation.Inverse();
+		auto Rebase = [&](FVehiclePhysicsInputRecord& State)
+		{
+			State.Position = Correction.Position + RotationCorrection.RotateVector(State.Position - Predicted.Position);
+			State.Rotation = RotationCorrection * State.Rotation;
+			State.Velocity = Correction.Velocity + RotationCorrection.RotateVector(State.Velocity - Predicted.Velocity);
+			State.AngularVelocity = Correction.AngularVelocity + RotationCorrection.RotateVector(State.AngularVelocity - Predicted.AngularVelocity);
+		};
+
+		FVehiclePhysicsInputRecord Body;
+		Body.Position = BodyHandle->X();
+		Body.Rotation = BodyHandle->R();
+		Body.Velocity = BodyHandle->V();
+		Body.AngularVelocity = BodyHandle->W();
+		Rebase(Body);
+		VehicleState.SetBodyState(Body);
+		for( int32 Index = CorrectedIndex; Index < Records.Num(); ++Index ) Rebase(Records[Index]);
+		return;
+	}
+
+	// Wheels start the replay from their current state, the server doesn't send it
+	ReplayWheelStates = VehicleState.WheelStates;
+	const FAVS_Inputs CurrentInputs = VehicleState.Inputs;
+	const bool bTelemetry = VehicleState.bTelemetry;
+	VehicleState.bTelemetry = false;
+
+	Corrected.Position = Correction.Position;
+	Corrected.Rotation = Correction.Rotation;
+	Corrected.Velocity = Correction.Velocity;
+	Corrected.AngularVelocity = Correction.AngularVelocity;
+	Corrected.bComplete = true;
+	VehicleState.SetBodyState(Corrected);
+
+	const float GravityZ = World->GetGravityZ();
+	for( int32 Index = CorrectedIndex + 1; Index < Records.Num(); ++Index )
+	{
+		FVehiclePhysicsInputRecord& Record = Records[Index];
+		VehicleState.Inputs = Record.Inputs;
+		AVehicleSystemBase::AVS_StepVehicle(Record.DeltaTime, World, VehicleInput, VehicleState, ReplayQueries, ReplayKernel, ReplayOutput);
+		VehicleState.IntegrateBody(Record.DeltaTime, GravityZ);
+		if( !Record.bComplete ) continue;
+
+		Record.Position = BodyHandle->X();
+		Record.Rotation = BodyHandle->R();
+		Record.Velocity = BodyHandle->V();
+		Record.AngularVelocity = BodyHandle->W();
 	}
+
+	VehicleState.WheelStates = ReplayWheelStates;
+	VehicleState.Inputs = CurrentInputs;
+	VehicleState.bTelemetry = bTelemetry;
+}
+
+void FVehiclePhysicsCallback::PushTelemetry(const FVehiclePhysicsVehicleInput& VehicleInput, FVehiclePhysicsVehicleState& VehicleState, const FVehiclePhysicsVehicleOutput& VehicleOutput)
+{
+	// Traces and forces were staged per vehicle, the ring only has one producer even when vehicles tick in parallel
+	for( FAVS_TelemetryRecord& Record : VehicleState.Telemetry )
+	{
+		Record.VehicleId = VehicleInput.VehicleId;
+		Record.Substep = TelemetrySubstep;
+		TelemetryRing.Push(Record);
+	}
+
+	const FAVS_Inputs& VehicleInputs = VehicleState.Inputs;
+	for( int32 WIndex = 0; WIndex < VehicleOutput.WheelOutputs.Num(); ++WIndex )
+	{
+		const FAVS1_Wheel_Output& WheelOutput = VehicleOutput.WheelOutputs[WIndex];
+		const EAVS_WheelFlags WheelFlags = VehicleInput.Wheels.Flags[WIndex];
+
+		FAVS_TelemetryRecord Record;
+		Record.Type = EAVS_TelemetryType::Wheel;
+		Record.WheelMode = EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::PhysicsMode) ? EWheelMode::Physics : EWheelMode::Raycast;
+		Record.bContact = WheelOutput.Contact.bBlockingHit;
+		Record.WheelIndex = static_cast<int16>(WIndex);
+		Record.VehicleId = VehicleInput.VehicleId;
+		Record.Substep = TelemetrySubstep;
+		Record.Point = WheelOutput.Contact.ImpactPoint;
+		Record.Slip = FVector2f(VehicleState.WheelStates[WIndex].Slip);
+		Record.SpringLength = WheelOutput.CurrentSpringLength;
+		Record.AngularVelocity = WheelOutput.AngularVelocity;
+		if( VehicleInputs.Torque > 0.0f && EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Driving) )
+		{
+			const bool bInvert = EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::InvertTorque) ^ VehicleInputs.ReverseTorque;
+			Record.DriveTorque = bInvert ? -VehicleInputs.Torque : VehicleInputs.Torque;
+		}
+		TelemetryRing.Push(Record);
+	}
+}
+
+const FVehiclePhysicsOutputSnapshot* FVehiclePhysicsCallback::ConsumeLatestOutput_External()
+{
+	if( !OutputBuffer.IsDirty() ) return nullptr;
+
+	OutputBuffer.SwapReadBuffers();
+	return &OutputBuffer.Read();
+}
+
+void FVehiclePhysicsCallback::InitializeTelemetry_External(int32 Capacity)
+{
+	if( !TelemetryRing.IsInitialized() ) TelemetryRing.Initialize(Capacity);
+}
+
+int32 FVehiclePhysicsCallback::DrainTelemetry_External(TArray<FAVS_TelemetryRecord>& OutRecords)
+{
+	return TelemetryRing.IsInitialized() ? TelemetryRing.Drain(OutRecords) : 0;
 }
 
 //RigidHandle Examples, ripped from ChaosVehicles
@@ -72,26 +523,19 @@ void FVehiclePhysicsCallback::OnContactModification_Internal(Chaos::FCollisionCo
 {
 	using namespace Chaos;
 	
-	if(VehicleMesh == nullptr)
+	if(DisabledContacts.Num() == 0)
 		return;
+
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_ContactModification);
 	
+	// One hashed lookup per pair, whatever the number of vehicles and wheels
 	for (Chaos::FContactPairModifier& PairModifier : Modifier)
 	{
-		FSingleParticlePhysicsProxy* ContactObject1 = static_cast<FSingleParticlePhysicsProxy*>(PairModifier.GetParticlePair()[0]->PhysicsProxy());
-		FSingleParticlePhysicsProxy* ContactObject2 = static_cast<FSingleParticlePhysicsProxy*>(PairModifier.GetParticlePair()[1]->PhysicsProxy());
-		if(ContactObject1 == VehicleMesh)
-		{
-			if(WheelMeshes.Contains(ContactObject2))
-			{
-				PairModifier.Disable(); // Disable Collision
-			}
-		}
-		else if (ContactObject2 == VehicleMesh)
+		const FSingleParticlePhysicsProxy* ContactObject1 = static_cast<const FSingleParticlePhysicsProxy*>(PairModifier.GetParticlePair()[0]->PhysicsProxy());
+		const FSingleParticlePhysicsProxy* ContactObject2 = static_cast<const FSingleParticlePhysicsProxy*>(PairModifier.GetParticlePair()[1]->PhysicsProxy());
+		if( DisabledContacts.Contains(FVehicleContactPair(ContactObject1, ContactObject2)) )
 		{
-			if(WheelMeshes.Contains(ContactObject1))
-			{
-				PairModifier.Disable(); // Disable Collision
-			}
+			PairModifier.Disable(); // Disable Collision
 		}
 	}
-}
\ No newline at end of file
+}
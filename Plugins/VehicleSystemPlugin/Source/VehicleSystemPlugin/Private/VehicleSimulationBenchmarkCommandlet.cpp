@@ -0,0 +1,300 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleSimulationBenchmarkCommandlet.h"
+
+#include "AVS_DEBUG.h"
+#include "VehicleSimulationSubsystem.h"
+#include "VehicleSystemBase.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace AVSBenchmark
+{
+	// Mean, median, 95th percentile and max of a sample set, in milliseconds
+	void LogTimings(const TCHAR* Name, TArray<double> Samples)
+	{
+		if( Samples.Num() == 0 ) return;
+
+		Samples.Sort();
+		double Total = 0.0;
+		for( const double Sample : Samples ) { Total += Sample; }
+		UE_LOG(LogAVS, Display, TEXT("%-24s mean %8.4f ms | p50 %8.4f ms | p95 %8.4f ms | max %8.4f ms"), Name, Total / Samples.Num(),
+			Samples[Samples.Num() / 2], Samples[FMath::Min(Samples.Num() - 1, FMath::FloorToInt(Samples.Num() * 0.95))], Samples.Last());
+	}
+}
+
+UVehicleSimulationBenchmarkCommandlet::UVehicleSimulationBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+FAVS_Inputs UVehicleSimulationBenchmarkCommandlet::GetScriptedInputs(int32 Step, int32 NumSteps, int32 VehicleIndex, float Torque)
+{
+	FAVS_Inputs Inputs;
+	const float Progress = static_cast<float>(Step) / FMath::Max(NumSteps, 1);
+	const float Side = (VehicleIndex % 2 == 0) ? 1.0f : -1.0f; // Neighbours weave in opposite directions
+
+	if( Progress < 0.4f ) // Accelerate
+	{
+		Inputs.Throttle = 1.0f;
+		Inputs.Torque = Torque;
+	}
+	else if( Progress < 0.7f ) // Weave
+	{
+		Inputs.Throttle = 0.6f;
+		Inputs.Torque = Torque * 0.6f;
+		Inputs.Steering = Side * FMath::Sin(Step * 0.05f);
+	}
+	else if( Progress < 0.9f ) // Brake
+	{
+		Inputs.Brake = 1.0f;
+		Inputs.Steering = Side * 0.3f;
+	}
+	else // Handbrake
+	{
+		Inputs.Handbrake = true;
+	}
+	return Inputs;
+}
+
+int32 UVehicleSimulationBenchmarkCommandlet::Main(const FString& Params)
+{
+	return Run(Params) ? 0 : 1;
+}
+
+FString UVehicleSimulationBenchmarkCommandlet::GetGoldenPath(const FString& GoldenName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("AVSBenchmark") / (GoldenName + TEXT(".csv"));
+}
+
+FString UVehicleSimulationBenchmarkCommandlet::LoadGoldenParams(const FString& FilePath)
+{
+	TArray<FString> Lines;
+	if( !FFileHelper::LoadFileToStringArray(Lines, *FilePath) || Lines.Num() == 0 || !Lines[0].StartsWith(TEXT("#")) ) return FString();
+	return Lines[0].RightChop(1).TrimStartAndEnd();
+}
+
+bool UVehicleSimulationBenchmarkCommandlet::Run(const FString& Params)
+{
+	FString VehicleClassPath;
+	FParse::Value(*Params, TEXT("Vehicle="), VehicleClassPath);
+	int32 NumVehicles = 16;
+	FParse::Value(*Params, TEXT("Count="), NumVehicles);
+	int32 NumSteps = 600;
+	FParse::Value(*Params, TEXT("Steps="), NumSteps);
+	int32 WarmupSteps = 60;
+	FParse::Value(*Params, TEXT("Warmup="), WarmupSteps);
+	float DeltaTime = 1.0f / 60.0f;
+	FParse::Value(*Params, TEXT("Dt="), DeltaTime);
+	float Torque = 600.0f;
+	FParse::Value(*Params, TEXT("Torque="), Torque);
+	FString MapName;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FString GoldenName = TEXT("Default");
+	FParse::Value(*Params, TEXT("Golden="), GoldenName);
+	float Tolerance = 1.0f;
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	const bool bWriteGolden = FParse::Param(*Params, TEXT("WriteGolden"));
+
+	// AVehicleSystemBase has no wheels, a benchmark without a vehicle class would measure nothing
+	if( VehicleClassPath.IsEmpty() )
+	{
+		UE_LOG(LogAVS, Error, TEXT("VehicleSimulationBenchmark: -Vehicle= is required, e.g. -Vehicle=/Game/Vehicles/BP_Car.BP_Car_C"));
+		return false;
+	}
+	UClass* VehicleClass = LoadClass<AVehicleSystemBase>(nullptr, *VehicleClassPath);
+	if( VehicleClass == nullptr )
+	{
+		UE_LOG(LogAVS, Error, TEXT("VehicleSimulationBenchmark: Could not load vehicle class %s"), *VehicleClassPath);
+		return false;
+	}
+
+	// ** World ** //
+
+	UWorld* World = nullptr;
+	if( MapName.IsEmpty() )
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("AVS_Benchmark"));
+	}
+	else if( UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None) )
+	{
+		World = UWorld::FindWorldInPackage(MapPackage);
+		if( World != nullptr )
+		{
+			World->WorldType = EWorldType::Game;
+			World->AddToRoot();
+			if( !World->bIsWorldInitialized ) World->InitWorld();
+		}
+	}
+	if( World == nullptr )
+	{
+		UE_LOG(LogAVS, Error, TEXT("VehicleSimulationBenchmark: Could not create world %s"), *MapName);
+		return false;
+	}
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->UpdateWorldComponents(true, false);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// Flat floor, a map is expected to have its own ground
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumVehicles)));
+	constexpr float VehicleSpacing = 1000.0f;
+	if( MapName.IsEmpty() )
+	{
+		// Deferred so the mesh is set before the static component is registered
+		const float FloorScale = GridSize * VehicleSpacing * 0.04f + 200.0f; // Room to drive away from the grid
+		const FTransform FloorTransform(FRotator::ZeroRotator, FVector(0.0f, 0.0f, -50.0f), FVector(FloorScale, FloorScale, 1.0f));
+		AStaticMeshActor* Floor = World->SpawnActorDeferred<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FloorTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		Floor->GetStaticMeshComponent()->SetStaticMesh(LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube")));
+		Floor->FinishSpawning(FloorTransform);
+	}
+
+	// Vehicles on a grid around the origin
+	TArray<AVehicleSystemBase*> Vehicles;
+	for( int32 Index = 0; Index < NumVehicles; ++Index )
+	{
+		const FVector Location((Index % GridSize - GridSize * 0.5f) * VehicleSpacing, (Index / GridSize - GridSize * 0.5f) * VehicleSpacing, 100.0f);
+		AVehicleSystemBase* Vehicle = World->SpawnActor<AVehicleSystemBase>(VehicleClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if( Vehicle == nullptr ) continue;
+		Vehicles.Add(Vehicle);
+	}
+	UE_LOG(LogAVS, Display, TEXT("VehicleSimulationBenchmark: %d x %s, %d steps of %f s"), Vehicles.Num(), *VehicleClass->GetName(), NumSteps, DeltaTime);
+
+	// ** Simulation ** //
+
+	UVehicleSimulationSubsystem* Simulation = World->GetSubsystem<UVehicleSimulationSubsystem>();
+	if( Simulation ) Simulation->SetRecordSubstepTimes(true);
+	TArray<double> PhysicsTimes;
+	TArray<double> WorldTickTimes;
+	PhysicsTimes.Reserve(NumSteps);
+	WorldTickTimes.Reserve(NumSteps);
+	uint64 WarmMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+	for( int32 Step = 0; Step < NumSteps; ++Step )
+	{
+		if( Step == WarmupSteps ) WarmMemory = FPlatformMemory::GetStats().UsedPhysical;
+		if( Simulation ) Simulation->ResetFrame_External(); // GFrameCounter doesn't advance without the engine loop
+
+		for( int32 Index = 0; Index < Vehicles.Num(); ++Index )
+		{
+			Vehicles[Index]->PhysicsThreadInputs(GetScriptedInputs(Step, NumSteps, Index, Torque));
+		}
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		World->Tick(LEVELTICK_All, DeltaTime);
+		const double WorldTickMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		// Every substep since the last step, the output snapshot only holds the latest one
+		const TArrayView<const FAVS_TelemetryRecord> Telemetry = Simulation ? Simulation->GetTelemetry() : TArrayView<const FAVS_TelemetryRecord>();
+		if( Step >= WarmupSteps )
+		{
+			WorldTickTimes.Add(WorldTickMs);
+			for( const FAVS_TelemetryRecord& Record : Telemetry )
+			{
+				if( Record.Type == EAVS_TelemetryType::Substep ) PhysicsTimes.Add(Record.SimulateMs);
+			}
+		}
+	}
+	if( Simulation )
+	{
+		Simulation->SetRecordSubstepTimes(false);
+		if( Simulation->GetDroppedTelemetryRecords() > 0 ) UE_LOG(LogAVS, Warning, TEXT("VehicleSimulationBenchmark: Substep times were dropped, the physics callback results are incomplete"));
+	}
+
+	const int64 MemoryGrowth = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - static_cast<int64>(WarmMemory);
+
+	AVSBenchmark::LogTimings(TEXT("Physics callback"), PhysicsTimes);
+	AVSBenchmark::LogTimings(TEXT("World tick (game thread)"), WorldTickTimes);
+	UE_LOG(LogAVS, Display, TEXT("%-24s %lld KB after warmup"), TEXT("Memory growth"), MemoryGrowth / 1024);
+
+	// ** Golden Data ** //
+
+	const FString GoldenPath = GetGoldenPath(GoldenName);
+	bool bSuccess;
+	if( bWriteGolden )
+	{
+		// Recorded with the settings so the automation test can simulate the same run again
+		FString GoldenParams = FString::Printf(TEXT("-Vehicle=%s -Count=%d -Steps=%d -Warmup=%d -Dt=%.9g -Torque=%.9g"), *VehicleClassPath, NumVehicles, NumSteps, WarmupSteps, DeltaTime, Torque);
+		if( !MapName.IsEmpty() ) GoldenParams += FString::Printf(TEXT(" -Map=%s"), *MapName);
+		bSuccess = WriteGolden(GoldenPath, GoldenParams, Vehicles);
+	}
+	else
+	{
+		bSuccess = CompareGolden(GoldenPath, Vehicles, Tolerance);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return bSuccess;
+}
+
+bool UVehicleSimulationBenchmarkCommandlet::WriteGolden(const FString& FilePath, const FString& GoldenParams, const TArray<AVehicleSystemBase*>& Vehicles)
+{
+	TArray<FString> Lines;
+	Lines.Add(TEXT("# ") + GoldenParams);
+	for( const AVehicleSystemBase* Vehicle : Vehicles )
+	{
+		const FVector Location = Vehicle->GetActorLocation();
+		const FRotator Rotation = Vehicle->GetActorRotation();
+		Lines.Add(FString::Printf(TEXT("%.4f,%.4f,%.4f,%.4f,%.4f,%.4f"), Location.X, Location.Y, Location.Z, Rotation.Pitch, Rotation.Yaw, Rotation.Roll));
+	}
+
+	if( !FFileHelper::SaveStringArrayToFile(Lines, *FilePath) )
+	{
+		UE_LOG(LogAVS, Error, TEXT("VehicleSimulationBenchmark: Could not write %s"), *FilePath);
+		return false;
+	}
+	UE_LOG(LogAVS, Display, TEXT("VehicleSimulationBenchmark: Golden transforms written to %s"), *FilePath);
+	return true;
+}
+
+bool UVehicleSimulationBenchmarkCommandlet::CompareGolden(const FString& FilePath, const TArray<AVehicleSystemBase*>& Vehicles, float Tolerance)
+{
+	TArray<FString> Lines;
+	if( !FFileHelper::LoadFileToStringArray(Lines, *FilePath) )
+	{
+		UE_LOG(LogAVS, Error, TEXT("VehicleSimulationBenchmark: No golden transforms at %s, run with -WriteGolden to record them"), *FilePath);
+		return false;
+	}
+	if( Lines.Num() > 0 && Lines[0].StartsWith(TEXT("#")) ) Lines.RemoveAt(0); // Recorded settings
+	if( Lines.Num() != Vehicles.Num() )
+	{
+		UE_LOG(LogAVS, Error, TEXT("VehicleSimulationBenchmark: Golden data has %d vehicles, simulated %d"), Lines.Num(), Vehicles.Num());
+		return false;
+	}
+
+	int32 NumMismatches = 0;
+	for( int32 Index = 0; Index < Vehicles.Num(); ++Index )
+	{
+		TArray<FString> Values;
+		Lines[Index].ParseIntoArray(Values, TEXT(","));
+		if( Values.Num() != 6 ) { ++NumMismatches; continue; }
+
+		const FVector GoldenLocation(FCString::Atod(*Values[0]), FCString::Atod(*Values[1]), FCString::Atod(*Values[2]));
+		const FRotator GoldenRotation(FCString::Atod(*Values[3]), FCString::Atod(*Values[4]), FCString::Atod(*Values[5]));
+		const float LocationError = FVector::Dist(GoldenLocation, Vehicles[Index]->GetActorLocation());
+		const float RotationError = FMath::RadiansToDegrees(GoldenRotation.Quaternion().AngularDistance(Vehicles[Index]->GetActorQuat()));
+		if( LocationError > Tolerance || RotationError > Tolerance )
+		{
+			UE_LOG(LogAVS, Error, TEXT("VehicleSimulationBenchmark: Vehicle %d is off by %.3f cm and %.3f degrees"), Index, LocationError, RotationError);
+			++NumMismatches;
+		}
+	}
+
+	UE_LOG(LogAVS, Display, TEXT("VehicleSimulationBenchmark: %d/%d vehicles match the golden transforms"), Vehicles.Num() - NumMismatches, Vehicles.Num());
+	return NumMismatches == 0;
+}
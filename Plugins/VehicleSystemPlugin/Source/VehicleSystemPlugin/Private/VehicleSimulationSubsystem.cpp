@@ -0,0 +1,451 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleSimulationSubsystem.h"
+
+#include "PBDRigidsSolver.h"
+#include "Algo/StableSort.h"
+#include "VehicleSystemBase.h"
+#include "VehicleSystemStats.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+static TAutoConsoleVariable<float> CVarAVSNetSendBudget(
+	TEXT("avs.Net.SendBudget"),
+	0.0f,
+	TEXT("Vehicle states per second the server relays across all vehicles with an adaptive send rate, 0 is unlimited"));
+
+static TAutoConsoleVariable<bool> CVarAVSNetBatchRelay(
+	TEXT("avs.Net.BatchRelay"),
+	false,
+	TEXT("Server sends the vehicle states of a frame to each connection in one batch, only for vehicles within their net cull distance"));
+
+static TAutoConsoleVariable<float> CVarAVSNetRelayCellSize(
+	TEXT("avs.Net.RelayCellSize"),
+	10000.0f,
+	TEXT("Size (cm) of the grid cells used to find the vehicles near each connection"));
+
+static TAutoConsoleVariable<bool> CVarAVSDebugTelemetry(
+	TEXT("avs.Debug.Telemetry"),
+	false,
+	TEXT("Records wheel traces, forces and states on the physics thread for the vehicle debug views"));
+
+static FAutoConsoleCommandWithWorld CmdAVSDebugDashboard(
+	TEXT("avs.Debug.Dashboard"),
+	TEXT("Toggles the ImGui vehicle telemetry window (Win64 only)"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if( UVehicleSimulationSubsystem* VehicleSimulation = World ? World->GetSubsystem<UVehicleSimulationSubsystem>() : nullptr )
+		{
+			VehicleSimulation->ToggleTelemetryDashboard();
+		}
+	}));
+
+static TAutoConsoleVariable<int32> CVarAVSLODFullBudget(
+	TEXT("avs.LOD.FullBudget"),
+	0,
+	TEXT("Vehicles using simulation LOD that can get the full simulation (LOD0), nearest first, the rest drop to LOD1. 0 is unlimited"));
+
+static TAutoConsoleVariable<int32> CVarAVSLODPhysicsBudget(
+	TEXT("avs.LOD.PhysicsBudget"),
+	0,
+	TEXT("Vehicles using simulation LOD that can be simulated with physics (LOD0 and LOD1), nearest first, the rest become kinematic (LOD2) when they can. 0 is unlimited"));
+
+void UVehicleSimulationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	PostLoginHandle = FGameModeEvents::GameModePostLoginEvent.AddUObject(this, &UVehicleSimulationSubsystem::OnPostLogin);
+}
+
+void UVehicleSimulationSubsystem::Deinitialize()
+{
+	FGameModeEvents::GameModePostLoginEvent.Remove(PostLoginHandle);
+	TelemetryDashboard.Reset();
+	FreePhysicsCallback();
+	PendingNetStates.Empty();
+	Super::Deinitialize();
+}
+
+void UVehicleSimulationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_Subsystem);
+	UpdateSimulationLODs();
+	RelayNetStates();
+
+	if( TelemetryDashboard.IsValid() )
+	{
+		if( TelemetryDashboard->IsOpen() ) TelemetryDashboard->Sample(DeltaTime);
+		else TelemetryDashboard.Reset(); // Closed from its window
+	}
+}
+
+void UVehicleSimulationSubsystem::ToggleTelemetryDashboard()
+{
+	if( TelemetryDashboard.IsValid() ) TelemetryDashboard.Reset();
+	else TelemetryDashboard = MakeUnique<FAVS_TelemetryDashboard>(this);
+}
+
+void UVehicleSimulationSubsystem::UpdateSimulationLODs()
+{
+	LODCandidates.Reset();
+	for( const TWeakObjectPtr<AVehicleSystemBase>& WeakVehicle : Vehicles )
+	{
+		AVehicleSystemBase* Vehicle = WeakVehicle.Get();
+		if( Vehicle == nullptr ) continue;
+
+		if( !Vehicle->UseSimulationLOD )
+		{
+			Vehicle->SetSimulationLOD(EVehicleSimulationLOD::LOD0);
+			continue;
+		}
+		LODCandidates.Add({ Vehicle, Vehicle->GetSimulationLODDistance() });
+	}
+	LODCandidates.Sort([](const FLODCandidate& A, const FLODCandidate& B) { return A.ViewerDistance < B.ViewerDistance; });
+
+	// Nearest vehicles get the budgets first
+	const int32 FullBudget = CVarAVSLODFullBudget.GetValueOnGameThread();
+	const int32 PhysicsBudget = CVarAVSLODPhysicsBudget.GetValueOnGameThread();
+	int32 NumFull = 0;
+	int32 NumPhysics = 0;
+	for( const FLODCandidate& Candidate : LODCandidates )
+	{
+		EVehicleSimulationLOD LOD = Candidate.Vehicle->GetDesiredSimulationLOD(Candidate.ViewerDistance);
+		if( LOD == EVehicleSimulationLOD::LOD0 && FullBudget > 0 && NumFull >= FullBudget ) LOD = EVehicleSimulationLOD::LOD1;
+		if( LOD != EVehicleSimulationLOD::LOD2 && PhysicsBudget > 0 && NumPhysics >= PhysicsBudget && Candidate.Vehicle->CanSimulateKinematic() ) LOD = EVehicleSimulationLOD::LOD2;
+
+		Candidate.Vehicle->SetSimulationLOD(LOD);
+		LOD = Candidate.Vehicle->SimulationLOD; // Kinematic can be refused
+		if( LOD == EVehicleSimulationLOD::LOD0 ) ++NumFull;
+		if( LOD != EVehicleSimulationLOD::LOD2 ) ++NumPhysics;
+	}
+}
+
+void UVehicleSimulationSubsystem::CreatePhysicsCallback()
+{
+	if( PhysicsCallback != nullptr ) return;
+
+	if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsCallback = PhysScene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FVehiclePhysicsCallback>(); // Unreal 5.1+
+	}
+}
+
+void UVehicleSimulationSubsystem::FreePhysicsCallback()
+{
+	if( PhysicsCallback == nullptr ) return;
+
+	if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(PhysicsCallback);
+	}
+	PhysicsCallback = nullptr;
+	CurrentInput = nullptr;
+	LatestOutput = nullptr;
+	TelemetryRecords.Reset();
+	TelemetryRanges.Reset();
+}
+
+int32 UVehicleSimulationSubsystem::RegisterVehicle(AVehicleSystemBase* Vehicle)
+{
+	CreatePhysicsCallback();
+	if( PhysicsCallback == nullptr ) return INDEX_NONE;
+
+	int32 VehicleId;
+	if( FreeVehicleIds.Num() > 0 )
+	{
+		VehicleId = FreeVehicleIds.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		VehicleId = Vehicles.AddDefaulted();
+		VehicleSerials.AddZeroed();
+		InputIndices.Add(INDEX_NONE);
+		OutputIndices.Add(INDEX_NONE);
+		NetSendRates.AddZeroed();
+	}
+
+	Vehicles[VehicleId] = Vehicle;
+	VehicleSerials[VehicleId] = NextVehicleSerial++;
+	InputIndices[VehicleId] = INDEX_NONE;
+	OutputIndices[VehicleId] = INDEX_NONE;
+	++NumRegisteredVehicles;
+	return VehicleId;
+}
+
+void UVehicleSimulationSubsystem::UnregisterVehicle(int32 VehicleId)
+{
+	if( !VehicleSerials.IsValidIndex(VehicleId) || VehicleSerials[VehicleId] == 0 ) return; // Not registered
+
+	Vehicles[VehicleId] = nullptr;
+	VehicleSerials[VehicleId] = 0;
+	OutputIndices[VehicleId] = INDEX_NONE;
+	SetNetSendRate(VehicleId, 0.0f);
+	FreeVehicleIds.Add(VehicleId);
+
+	// Physics callback is only needed while vehicles exist, the physics scene may be gone by the time we deinitialize
+	if( --NumRegisteredVehicles == 0 )
+	{
+		FreePhysicsCallback();
+	}
+}
+
+AVehicleSystemBase* UVehicleSimulationSubsystem::GetVehicle(int32 VehicleId) const
+{
+	return Vehicles.IsValidIndex(VehicleId) ? Vehicles[VehicleId].Get() : nullptr;
+}
+
+FVehiclePhysicsVehicleInput* UVehicleSimulationSubsystem::GetVehicleInput_External(int32 VehicleId)
+{
+	if( PhysicsCallback == nullptr || !Vehicles.IsValidIndex(VehicleId) ) return nullptr;
+
+	// The producer input stays the same until the solver consumes it, vehicle slots are rebuilt for every new input
+	FVehiclePhysicsPhysicsInput* PhysicsInput = PhysicsCallback->GetProducerInputData_External();
+	if( PhysicsInput != CurrentInput || CurrentInputFrame != GFrameCounter )
+	{
+		CurrentInput = PhysicsInput;
+		CurrentInputFrame = GFrameCounter;
+		for( int32& InputIndex : InputIndices ) { InputIndex = INDEX_NONE; }
+	}
+	PhysicsInput->World = GetWorld();
+	PhysicsInput->bTelemetry = IsTelemetryEnabled();
+	PhysicsInput->bSubstepTimes = bRecordSubstepTimes;
+	PhysicsInput->SurfaceFrictions = SurfaceFrictions;
+	if( PhysicsInput->bTelemetry || PhysicsInput->bSubstepTimes ) PhysicsCallback->InitializeTelemetry_External(TelemetryCapacity);
+
+	int32& InputIndex = InputIndices[VehicleId];
+	if( InputIndex != INDEX_NONE && InputIndex < PhysicsInput->NumVehicles && PhysicsInput->Vehicles[InputIndex].VehicleId == VehicleId )
+	{
+		return &PhysicsInput->Vehicles[InputIndex];
+	}
+
+	InputIndex = PhysicsInput->NumVehicles;
+	FVehiclePhysicsVehicleInput& VehicleInput = PhysicsInput->AddVehicle(); // Reused entry, fields are overwritten by the vehicle
+	VehicleInput.VehicleId = VehicleId;
+	VehicleInput.VehicleSerial = VehicleSerials[VehicleId];
+	return &VehicleInput;
+}
+
+bool UVehicleSimulationSubsystem::IsTelemetryEnabled() const
+{
+	#if AVS_TELEMETRY
+	return NumTelemetryViewers > 0 || CVarAVSDebugTelemetry.GetValueOnGameThread();
+	#else
+	return false;
+	#endif
+}
+
+void UVehicleSimulationSubsystem::DrainTelemetry_External()
+{
+	// Drained once per frame, every reader sees the same records
+	if( LastTelemetryFrame == GFrameCounter ) return;
+	LastTelemetryFrame = GFrameCounter;
+
+	TelemetryRecords.Reset();
+	TelemetryRanges.Reset();
+	DroppedTelemetryRecords = 0;
+	if( PhysicsCallback == nullptr ) return;
+
+	DroppedTelemetryRecords = PhysicsCallback->DrainTelemetry_External(TelemetryRecords);
+	if( TelemetryRecords.Num() == 0 ) return;
+
+	// Stable so the records of each vehicle stay in the order they were pushed
+	Algo::StableSortBy(TelemetryRecords, &FAVS_TelemetryRecord::VehicleId);
+
+	TelemetryRanges.SetNumZeroed(Vehicles.Num());
+	for( int32 First = 0; First < TelemetryRecords.Num(); )
+	{
+		const int32 VehicleId = TelemetryRecords[First].VehicleId;
+		int32 Last = First + 1;
+		while( Last < TelemetryRecords.Num() && TelemetryRecords[Last].VehicleId == VehicleId ) ++Last;
+		if( TelemetryRanges.IsValidIndex(VehicleId) ) TelemetryRanges[VehicleId] = FIntPoint(First, Last - First);
+		First = Last;
+	}
+}
+
+TArrayView<const FAVS_TelemetryRecord> UVehicleSimulationSubsystem::GetVehicleTelemetry(int32 VehicleId)
+{
+	DrainTelemetry_External();
+	if( !TelemetryRanges.IsValidIndex(VehicleId) ) return {};
+
+	const FIntPoint& Range = TelemetryRanges[VehicleId];
+	return MakeArrayView(TelemetryRecords.GetData() + Range.X, Range.Y);
+}
+
+void UVehicleSimulationSubsystem::ConsumeOutputs_External()
+{
+	// Physics Thread Outputs: Only the most recent step is read, steps made in between are skipped
+	if( PhysicsCallback == nullptr || LastOutputFrame == GFrameCounter ) return;
+	LastOutputFrame = GFrameCounter;
+
+	LatestOutput = PhysicsCallback->ConsumeLatestOutput_External();
+	if( LatestOutput == nullptr ) return;
+
+	ChaosDeltaTime = LatestOutput->ChaosDeltaTime;
+	for( int32& OutputIndex : OutputIndices ) { OutputIndex = INDEX_NONE; }
+	for( int32 OutputIndex = 0; OutputIndex < LatestOutput->NumVehicles; ++OutputIndex )
+	{
+		const FVehiclePhysicsVehicleOutput& VehicleOutput = LatestOutput->Vehicles[OutputIndex];
+		if( GetVehicleSerial(VehicleOutput.VehicleId) != VehicleOutput.VehicleSerial ) continue; // Vehicle was removed after this step
+		OutputIndices[VehicleOutput.VehicleId] = OutputIndex;
+	}
+}
+
+void UVehicleSimulationSubsystem::ResetFrame_External()
+{
+	// Per frame caches are keyed on GFrameCounter, a frame it never reaches makes them refresh on the next call
+	CurrentInputFrame = MAX_uint64;
+	LastOutputFrame = MAX_uint64;
+	LastTelemetryFrame = MAX_uint64;
+}
+
+void UVehicleSimulationSubsystem::AddSurfaceMaterial(const TWeakObjectPtr<UPhysicalMaterial>& PhysMaterial)
+{
+	const UPhysicalMaterial* Material = PhysMaterial.Get();
+	if( Material == nullptr ) return;
+
+	const float* Friction = SurfaceFrictions.IsValid() ? SurfaceFrictions->Frictions.Find(PhysMaterial) : nullptr;
+	if( Friction && *Friction == Material->Friction ) return;
+
+	// The physics thread may still read the current table, a new one is shared from the next input on
+	TSharedPtr<FAVS_SurfaceFrictionTable, ESPMode::ThreadSafe> NewFrictions = SurfaceFrictions.IsValid() ? MakeShared<FAVS_SurfaceFrictionTable, ESPMode::ThreadSafe>(*SurfaceFrictions) : MakeShared<FAVS_SurfaceFrictionTable, ESPMode::ThreadSafe>();
+	NewFrictions->Frictions.Add(PhysMaterial, Material->Friction);
+	SurfaceFrictions = NewFrictions;
+}
+
+const FVehiclePhysicsVehicleOutput* UVehicleSimulationSubsystem::GetVehicleOutput_External(int32 VehicleId)
+{
+	ConsumeOutputs_External();
+
+	if( LatestOutput == nullptr || !OutputIndices.IsValidIndex(VehicleId) || OutputIndices[VehicleId] == INDEX_NONE ) return nullptr;
+	return &LatestOutput->Vehicles[OutputIndices[VehicleId]];
+}
+
+void UVehicleSimulationSubsystem::SetNetSendRate(int32 VehicleId, float SendRate)
+{
+	if( !NetSendRates.IsValidIndex(VehicleId) ) return;
+
+	TotalNetSendRate = FMath::Max(TotalNetSendRate + SendRate - NetSendRates[VehicleId], 0.0f);
+	NetSendRates[VehicleId] = SendRate;
+}
+
+float UVehicleSimulationSubsystem::GetNetSendBudgetScale() const
+{
+	const float SendBudget = CVarAVSNetSendBudget.GetValueOnGameThread();
+	if( SendBudget <= 0.0f || TotalNetSendRate <= SendBudget ) return 1.0f;
+	return SendBudget / TotalNetSendRate;
+}
+
+bool UVehicleSimulationSubsystem::QueueNetStateRelay(AVehicleSystemBase* Vehicle, const FNetState& State)
+{
+	if( !CVarAVSNetBatchRelay.GetValueOnGameThread() || GetWorld()->GetNetMode() == NM_Client ) return false;
+
+	PendingNetStates.Add({ Vehicle, State });
+	return true;
+}
+
+void UVehicleSimulationSubsystem::RelayNetStates()
+{
+	if( PendingNetStates.Num() == 0 ) return;
+
+	const float CellSize = FMath::Max(CVarAVSNetRelayCellSize.GetValueOnGameThread(), 100.0f);
+	auto GetCell = [CellSize](const FVector& Location)
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+	};
+
+	// The server copy syncs like any other client, then the states are bucketed by position
+	RelayCells.Reset();
+	float MaxCullDistanceSquared = 0.0f;
+	for( int32 PendingIndex = 0; PendingIndex < PendingNetStates.Num(); ++PendingIndex )
+	{
+		AVehicleSystemBase* Vehicle = PendingNetStates[PendingIndex].Vehicle.Get();
+		if( !IsValid(Vehicle) ) continue;
+
+		Vehicle->ReceiveNetState(PendingNetStates[PendingIndex].State);
+		RelayCells.FindOrAdd(GetCell(Vehicle->GetActorLocation())).Add(PendingIndex);
+		MaxCullDistanceSquared = FMath::Max(MaxCullDistanceSquared, Vehicle->bAlwaysRelevant ? TNumericLimits<float>::Max() : Vehicle->GetNetCullDistanceSquared());
+	}
+
+	// Visit the cells in range of each viewer, or every cell once the range covers more cells than exist
+	const float CellRange = FMath::Sqrt(MaxCullDistanceSquared) / CellSize;
+	const int32 NumCellsInRange = CellRange < 1000.0f ? FMath::Square(2 * FMath::CeilToInt32(CellRange) + 1) : MAX_int32;
+	const bool VisitAllCells = NumCellsInRange >= RelayCells.Num();
+
+	for( FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator )
+	{
+		APlayerController* PlayerController = Iterator->Get();
+		if( PlayerController == nullptr || PlayerController->IsLocalController() ) continue; // Local viewers use the server copy
+
+		// Controllers that joined without a login (seamless travel) get theirs now, nothing is sent until the client has it
+		UVehicleNetRelayComponent* RelayComponent = AddRelayComponent(PlayerController);
+		if( !RelayComponent->IsClientReady() ) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		auto AddCell = [&](const TArray<int32>& Cell)
+		{
+			for( const int32 PendingIndex : Cell )
+			{
+				const FPendingNetState& Pending = PendingNetStates[PendingIndex];
+				AVehicleSystemBase* Vehicle = Pending.Vehicle.Get();
+				if( Vehicle->GetController() == PlayerController ) continue; // Owner sent it
+
+				if( !Vehicle->bAlwaysRelevant && FVector::DistSquared(ViewLocation, Vehicle->GetActorLocation()) > Vehicle->GetNetCullDistanceSquared() ) continue;
+
+				RelayBatch.Add({ Vehicle, Pending.State });
+				if( RelayBatch.Num() == UVehicleNetRelayComponent::MaxBatchSize ) SendRelayBatch(RelayComponent);
+			}
+		};
+
+		if( VisitAllCells )
+		{
+			for( const TPair<FIntPoint, TArray<int32>>& Cell : RelayCells ) { AddCell(Cell.Value); }
+		}
+		else
+		{
+			const FIntPoint ViewCell = GetCell(ViewLocation);
+			const int32 Range = FMath::CeilToInt32(CellRange);
+			for( int32 X = ViewCell.X - Range; X <= ViewCell.X + Range; ++X )
+			{
+				for( int32 Y = ViewCell.Y - Range; Y <= ViewCell.Y + Range; ++Y )
+				{
+					if( const TArray<int32>* Cell = RelayCells.Find(FIntPoint(X, Y)) ) { AddCell(*Cell); }
+				}
+			}
+		}
+		SendRelayBatch(RelayComponent);
+	}
+
+	PendingNetStates.Reset();
+}
+
+void UVehicleSimulationSubsystem::OnPostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer)
+{
+	if( GameMode == nullptr || GameMode->GetWorld() != GetWorld() || NewPlayer == nullptr || NewPlayer->IsLocalController() ) return;
+	AddRelayComponent(NewPlayer);
+}
+
+UVehicleNetRelayComponent* UVehicleSimulationSubsystem::AddRelayComponent(APlayerController* PlayerController)
+{
+	UVehicleNetRelayComponent* RelayComponent = PlayerController->FindComponentByClass<UVehicleNetRelayComponent>();
+	if( RelayComponent == nullptr )
+	{
+		RelayComponent = NewObject<UVehicleNetRelayComponent>(PlayerController);
+		RelayComponent->RegisterComponent();
+	}
+	return RelayComponent;
+}
+
+void UVehicleSimulationSubsystem::SendRelayBatch(UVehicleNetRelayComponent* RelayComponent)
+{
+	if( RelayBatch.Num() == 0 ) return;
+
+	RelayComponent->Client_ReceiveNetStates(RelayBatch);
+	RelayBatch.Reset();
+}
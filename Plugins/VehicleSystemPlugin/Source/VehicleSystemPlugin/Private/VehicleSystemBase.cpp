@@ -1,22 +1,174 @@
 // Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
 // Unauthorized copying of this file, via any medium is strictly prohibited
 
-#define DEBUG(format, value) FString::Printf(TEXT(format), value)
-
 #include "VehicleSystemBase.h"
 
 #include "AVS_DEBUG.h"
 #include "PBDRigidsSolver.h"
 #include "TimerManager.h"
+#include "VehicleSimulationSubsystem.h"
 #include "VehicleSystemFunctions.h"
+#include "VehicleSystemStats.h"
+#include "VehicleWheelQuery.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/NetSerialization.h"
 #include "Kismet/KismetMathLibrary.h"
-#include "Kismet/KismetSystemLibrary.h"
 #include "Net/UnrealNetwork.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Serialization/BitWriter.h"
 #include "Physics/Experimental/PhysScene_Chaos.h"
 #include "Runtime/Engine/Classes/Camera/PlayerCameraManager.h"
 #include "Runtime/Engine/Classes/GameFramework/PlayerController.h"
 
+// ** Net State ** //
+
+namespace AVSNetState
+{
+	constexpr int32 QuatComponentBits = 15;
+
+	// Smallest three: the largest component is dropped and rebuilt from the other three, which fit in +-1/sqrt(2)
+	void SerializeQuat(FArchive& Ar, FQuat& Quat)
+	{
+		constexpr uint32 ComponentMax = (1 << QuatComponentBits) - 1;
+		uint32 LargestIndex = 0;
+		uint32 Packed[3] = { 0, 0, 0 };
+
+		if( Ar.IsSaving() )
+		{
+			const FQuat Normalized = Quat.GetNormalized();
+			const double Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+			for( uint32 Index = 1; Index < 4; ++Index )
+			{
+				if( FMath::Abs(Components[Index]) > FMath::Abs(Components[LargestIndex]) ) LargestIndex = Index;
+			}
+
+			const double Sign = (Components[LargestIndex] < 0.0) ? -1.0 : 1.0; // Q and -Q are the same rotation, the dropped component is always positive
+			for( uint32 Index = 0, PackedIndex = 0; Index < 4; ++Index )
+			{
+				if( Index == LargestIndex ) continue;
+				const double Normal = (Components[Index] * Sign * UE_DOUBLE_SQRT_2 + 1.0) * 0.5; // 0-1
+				Packed[PackedIndex++] = static_cast<uint32>(FMath::Clamp(FMath::RoundToInt(Normal * ComponentMax), 0, (int32)ComponentMax));
+			}
+		}
+
+		Ar.SerializeInt(LargestIndex, 4);
+		for( uint32& Value : Packed ) { Ar.SerializeInt(Value, ComponentMax + 1); }
+
+		if( Ar.IsLoading() )
+		{
+			double Components[4];
+			double SumSquared = 0.0;
+			for( uint32 Index = 0, PackedIndex = 0; Index < 4; ++Index )
+			{
+				if( Index == LargestIndex ) continue;
+				Components[Index] = (Packed[PackedIndex++] / static_cast<double>(ComponentMax) * 2.0 - 1.0) * UE_DOUBLE_INV_SQRT_2;
+				SumSquared += Components[Index] * Components[Index];
+			}
+			Components[LargestIndex] = FMath::Sqrt(FMath::Max(0.0, 1.0 - SumSquared));
+			Quat = FQuat(Components[0], Components[1], Components[2], Components[3]).GetNormalized();
+		}
+	}
+}
+
+void FNetState::MakeDelta(const FNetState& Keyframe)
+{
+	KeyframeSequence = Keyframe.Sequence;
+	position -= Keyframe.position;
+	NetTimestamp -= Keyframe.NetTimestamp;
+}
+
+void FNetState::ApplyDelta(const FNetState& Keyframe)
+{
+	position += Keyframe.position;
+	NetTimestamp += Keyframe.NetTimestamp;
+}
+
+bool FNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint8 Keyframe = IsKeyframe() ? 1 : 0;
+	Ar.SerializeBits(&Keyframe, 1);
+	Ar << Sequence;
+
+	if( Keyframe )
+	{
+		KeyframeSequence = Sequence;
+		Ar << NetTimestamp;
+	}
+	else
+	{
+		// Keyframe is a few sends old, the time since it fits in a few bits as whole milliseconds
+		uint32 KeyframeAge = static_cast<uint16>(Sequence - KeyframeSequence);
+		Ar.SerializeIntPacked(KeyframeAge);
+		KeyframeSequence = static_cast<uint16>(Sequence - KeyframeAge);
+
+		uint32 TimeDeltaMs = Ar.IsSaving() ? static_cast<uint32>(FMath::RoundToInt(FMath::Max(NetTimestamp, 0.0f) * 1000.0f)) : 0;
+		Ar.SerializeIntPacked(TimeDeltaMs);
+		if( Ar.IsLoading() ) NetTimestamp = TimeDeltaMs * 0.001f;
+	}
+
+	// Packed vectors only use the bits the value needs, deltas stay small while close to the keyframe
+	bOutSuccess &= SerializePackedVector<10, 30>(position, Ar);
+
+	FQuat Quat = Ar.IsSaving() ? rotation.Quaternion() : FQuat::Identity;
+	AVSNetState::SerializeQuat(Ar, Quat);
+	if( Ar.IsLoading() ) rotation = Quat.Rotator();
+
+	bOutSuccess &= SerializePackedVector<1, 20>(velocity, Ar);
+	bOutSuccess &= SerializePackedVector<10, 20>(angularVelocity, Ar);
+	return true;
+}
+
+void FNetStateQueue::SetCapacity(int32 NewCapacity)
+{
+	States.SetNum(FMath::Max(NewCapacity, 1));
+	Reset();
+}
+
+FNetStateQueue::EInsertResult FNetStateQueue::Insert(const FNetState& State, float LocalTimestamp)
+{
+	if( States.Num() == 0 ) SetCapacity(1);
+	if( Count == States.Num() ) return EInsertResult::Overflow;
+
+	if( Count == 0 )
+	{
+		BaseLocalTimestamp = LocalTimestamp;
+		BaseNetTimestamp = State.NetTimestamp;
+		At(0) = State;
+		Count = 1;
+		return EInsertResult::Added;
+	}
+
+	// Find the slot from the newest state, states usually arrive in order so this stops right away
+	int32 Index = Count;
+	while( Index > 0 && At(Index - 1).NetTimestamp >= State.NetTimestamp ) { --Index; }
+
+	// The front is our point of reference and could be actively syncing
+	if( Index == 0 ) return EInsertResult::Late;
+
+	for( int32 Move = Count; Move > Index; --Move ) { At(Move) = At(Move - 1); }
+	At(Index) = State;
+	++Count;
+	return EInsertResult::Added;
+}
+
+FNetState FNetStateQueue::GetFront() const
+{
+	check(Count > 0);
+	FNetState Front = At(0);
+	// Apply the time difference in the owners times to our local time
+	Front.LocalTimestamp = BaseLocalTimestamp + (Front.NetTimestamp - BaseNetTimestamp);
+	return Front;
+}
+
+void FNetStateQueue::PopFront()
+{
+	if( Count == 0 ) return;
+	Head = (Head + 1) % States.Num();
+	--Count;
+}
+
 AVehicleSystemBase::AVehicleSystemBase()
 {
 	bReplicates = true;
@@ -46,6 +198,7 @@ void AVehicleSystemBase::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	DOREPLIFETIME(AVehicleSystemBase, RestState);
+	DOREPLIFETIME_CONDITION(AVehicleSystemBase, NetSendInterval, COND_OwnerOnly);
 }
 
 void AVehicleSystemBase::BeginPlay()
@@ -62,14 +215,8 @@ void AVehicleSystemBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	Super::EndPlay(EndPlayReason);
 	if(IsPhysicsCallbackRegistered())
 	{
-		if (UWorld* World = GetWorld())
-		{
-			if (FPhysScene* PhysScene = World->GetPhysicsScene())
-			{
-				PhysScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(PhysicsThreadCallback);
-				PhysicsThreadCallback = nullptr;
-			}
-		}
+		VehicleSimulation->UnregisterVehicle(VehicleSimulationId);
+		VehicleSimulationId = INDEX_NONE;
 	}
 }
 
@@ -104,7 +251,7 @@ void AVehicleSystemBase::PassiveStateChanged_Implementation(bool NewPassiveState
 // Sets IsVehicleAtRest to true if the vehicle is within the velocity threshold for 3 seconds
 void AVehicleSystemBase::DetermineLocalRestState()
 {
-	bool WithinRestThreshold = VehicleMesh->GetPhysicsLinearVelocity().Size() <= RestVelocityThreshold; // Vehicle is moving slow enough to be considered not moving (resting)
+	bool WithinRestThreshold = GetVehicleVelocity().Size() <= RestVelocityThreshold; // Vehicle is moving slow enough to be considered not moving (resting)
 	if (WithinRestThreshold) // Meets resting requirements
 	{
 		if (!LocalVehicleAtRest) // Variable not resting yet
@@ -143,6 +290,7 @@ void AVehicleSystemBase::TickActor(float DeltaTime, ELevelTick TickType, FActorT
 			PassiveStateChanged(NewPassive);
 		}
 		AlwaysTick();
+		UpdateWheelVisuals(DeltaTime);
 		if( PassiveMode && PassiveTickGatekeeping ){ PassiveTick(DeltaTime); return; } // Disallow standard tick when in passive mode
 		Super::TickActor(DeltaTime, TickType, ThisTickFunction); // Super will call standard Tick function
 	}
@@ -150,26 +298,60 @@ void AVehicleSystemBase::TickActor(float DeltaTime, ELevelTick TickType, FActorT
 
 void AVehicleSystemBase::AlwaysTick()
 {
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_AlwaysTick);
 	NetworkTick();
 
+	if( SimulationLOD == EVehicleSimulationLOD::LOD2 ) { KinematicTick(TickDeltaTime); return; }
+
 	// Physics Thread
 	if( VehicleMesh->IsSimulatingPhysics() )
 	{
 		// Physics thread updates
 		if( !IsPhysicsCallbackRegistered() ) return;
 
+		// Newest received inputs decide whether the server wakes the vehicle, the physics thread simulates every frame in order
+		if( IsServerSimulated() && ServerInputQueue.Num() > 0 ) InputsForPhysicsThread = ServerInputQueue.Last().Inputs;
+
+		// Parked, the physics thread skips the vehicle until its body is woken by a contact or we have input for it
+		const bool bDormancyWake = HasDormancyWakeInput();
+		if( PhysicsDormancy && PhysicsDormant && !bDormancyWake && !VehicleMesh->IsAnyRigidBodyAwake() )
+		{
+			// Still filtered, a contact can wake the body before the game thread sends a full input again
+			if( FVehiclePhysicsVehicleInput* PhysicsInput = VehicleSimulation->GetVehicleInput_External(VehicleSimulationId) )
+			{
+				PhysicsInput->bContactsOnly = true;
+				PhysicsInput->VehicleProxy = VehicleMesh->GetBodyInstance()->GetPhysicsActorHandle();
+				PhysicsInput->ContactModProxies = ContactModProxies;
+			}
+			return;
+		}
+
 		// Physics Thread Inputs
-		FVehiclePhysicsPhysicsInput* PhysicsInput = PhysicsThreadCallback->GetProducerInputData_External();
-		PhysicsInput->World = GetWorld();
-		PhysicsInput->VehicleActor = this;
-		PhysicsInput->VehicleMeshPrim = VehicleMesh;
+		FVehiclePhysicsVehicleInput* PhysicsInput = VehicleSimulation->GetVehicleInput_External(VehicleSimulationId);
+		if( PhysicsInput == nullptr ) return;
+
+		PhysicsInput->bContactsOnly = false;
+		PhysicsInput->VehicleActorId = GetUniqueID();
 		PhysicsInput->VehicleMass = VehicleMesh->GetMass();
 		PhysicsInput->VehicleInputs = InputsForPhysicsThread;
+		SetPhysicsInputFrames(*PhysicsInput);
+		PhysicsInput->SimulationLOD = SimulationLOD;
+		PhysicsInput->ContactCacheMaxSpeed = RestVelocityThreshold;
+		PhysicsInput->ContactCacheTolerance = UseContactCache ? ContactCacheTolerance : 0.0f;
+		PhysicsInput->DormancyDelay = PhysicsDormancy ? FMath::Max(DormancyDelay, KINDA_SMALL_NUMBER) : 0.0f;
+		PhysicsInput->DormancySleepSpeed = RestVelocityThreshold;
+		PhysicsInput->DormancyWakeSpeed = FMath::Max(DormancyWakeVelocity, RestVelocityThreshold);
+		PhysicsInput->DormancySleepAngularSpeed = DormancyRestAngularVelocity;
+		PhysicsInput->DormancyWakeAngularSpeed = FMath::Max(DormancyWakeAngularVelocity, DormancyRestAngularVelocity);
+		PhysicsInput->bDormancyWake = bDormancyWake;
+		PhysicsInput->VehicleProxy = VehicleMesh->GetBodyInstance()->GetPhysicsActorHandle();
+		PhysicsInput->ContactModProxies = ContactModProxies;
 
 		PhysicsInput->Wheels.Reset();
 		PhysicsInput->Wheels.Reserve(VehicleWheels.Num());
 
-		TArray<UVehicleWheelBase*> SimulatedWheels;
+		TArray<UVehicleWheelBase*, TInlineAllocator<8>> SimulatedWheels;
+		uint32 ColdHash = 0;
 		for( UVehicleWheelBase* Wheel : VehicleWheels )
 		{
 			if( !IsValid(Wheel) ) continue;
@@ -178,27 +360,37 @@ void AVehicleSystemBase::AlwaysTick()
 			{
 				PhysicsInput->Wheels.Add(Wheel->WheelConfig);
 				SimulatedWheels.Add(Wheel);
+				ColdHash = HashCombineFast(ColdHash, FAVS_WheelColdBlock::GetColdHash(Wheel->WheelConfig));
 			}
 		}
 
-		TArray<FString> DebugTexts;
-		TArray<FAVS1_Wheel_Output> WheelOutputs;
-		// Physics Thread Outputs: Done in a while loop because there can be multiple outputs made between frames
-		Chaos::TSimCallbackOutputHandle<FVehiclePhysicsPhysicsOutput> PhysicsOutput;
-		while( (PhysicsOutput = PhysicsThreadCallback->PopOutputData_External()) )
+		// Cold wheel data is only rebuilt when it changes, the physics thread shares the same block until then
+		ColdHash = HashCombineFast(ColdHash, SimulatedWheels.Num());
+		if( !WheelColdBlock.IsValid() || ColdHash != WheelColdHash )
 		{
-			ChaosDeltaTime = PhysicsOutput->ChaosDeltaTime;
-			DebugTraces = PhysicsOutput->DebugTraces;
-			DebugForces = PhysicsOutput->DebugForces;
-			WheelOutputs = PhysicsOutput->WheelOutputs;
-			DebugTexts = PhysicsOutput->DebugTexts;
+			TSharedRef<FAVS_WheelColdBlock, ESPMode::ThreadSafe> NewColdBlock = MakeShared<FAVS_WheelColdBlock, ESPMode::ThreadSafe>();
+			NewColdBlock->Wheels.Reserve(SimulatedWheels.Num());
+			for( const UVehicleWheelBase* Wheel : SimulatedWheels )
+			{
+				NewColdBlock->Add(Wheel->WheelConfig);
+			}
+			WheelColdBlock = NewColdBlock;
+			WheelColdHash = ColdHash;
 		}
+		PhysicsInput->ColdWheels = WheelColdBlock;
 
-		// Prints all saved debug texts
-		for( int32 i = 0; i < DebugTexts.Num(); i++ )
-		{
-			UVehicleSystemFunctions::PrintToScreenWithTag(DebugTexts[i], FLinearColor::Yellow, 0.1f, i);
-		}
+		// Physics Thread Outputs: Latest output received this frame, if any
+		const FVehiclePhysicsVehicleOutput* PhysicsOutput = VehicleSimulation->GetVehicleOutput_External(VehicleSimulationId);
+		if( PhysicsOutput == nullptr ) return;
+
+		ChaosDeltaTime = VehicleSimulation->GetChaosDeltaTime();
+		PhysicsDormant = PhysicsOutput->bDormant;
+		if( IsPredictingOwner() ) RecordPredictedFrames(*PhysicsOutput);
+		else if( IsServerSimulated() ) ConsumeServerFrames(*PhysicsOutput);
+		if( PhysicsDormant ) return; // Wheels keep their last output
+
+		UpdateDebugTelemetry();
+		const TArray<FAVS1_Wheel_Output>& WheelOutputs = PhysicsOutput->WheelOutputs;
 
 		// Wait for the next frame if outputs do not match inputs
 		if( WheelOutputs.Num() != SimulatedWheels.Num() ) return;
@@ -208,12 +400,181 @@ void AVehicleSystemBase::AlwaysTick()
 		{
 			if( SimulatedWheels.IsValidIndex(Index) )
 			{
-				SimulatedWheels[Index]->WheelData = WheelOutputs[Index];
+				FAVS1_Wheel_Output& WheelData = SimulatedWheels[Index]->WheelData;
+				WheelData = WheelOutputs[Index];
+				WheelData.Contact.ResolveSurfaceType(); // UObjects are only resolved on the game thread
+				VehicleSimulation->AddSurfaceMaterial(WheelData.Contact.PhysMaterial);
+				SimulatedWheels[Index]->MarkLastTraceDirty();
 			}
 		}
 	}
 }
 
+void AVehicleSystemBase::UpdateDebugTelemetry()
+{
+	DebugTraces.Reset();
+	DebugForces.Reset();
+	if( VehicleSimulation == nullptr || !VehicleSimulation->IsTelemetryEnabled() ) return;
+
+	// Several substeps may have been drained this frame, only the latest one is kept
+	const TArrayView<const FAVS_TelemetryRecord> Records = VehicleSimulation->GetVehicleTelemetry(VehicleSimulationId);
+	if( Records.Num() == 0 ) return;
+	const uint32 LatestSubstep = Records.Last().Substep;
+
+	for( const FAVS_TelemetryRecord& Record : Records )
+	{
+		if( Record.Substep != LatestSubstep ) continue;
+
+		if( Record.Type == EAVS_TelemetryType::Trace )
+		{
+			FHitResult& Trace = DebugTraces.AddDefaulted_GetRef();
+			Trace.TraceStart = Record.Start;
+			Trace.TraceEnd = Record.End;
+			Trace.ImpactPoint = Record.Point;
+			Trace.Location = Record.Point;
+			Trace.bBlockingHit = Record.bContact;
+		}
+		else if( Record.Type == EAVS_TelemetryType::Force )
+		{
+			DebugForces.Add(FDebugForce(Record.Start, Record.End, Record.WheelMode));
+		}
+	}
+}
+
+bool AVehicleSystemBase::HasDormancyWakeInput() const
+{
+	const FAVS_Inputs& Inputs = InputsForPhysicsThread;
+	return !FMath::IsNearlyZero(Inputs.Throttle) || !FMath::IsNearlyZero(Inputs.Torque) || !FMath::IsNearlyZero(Inputs.Steering) || !FMath::IsNearlyZero(Inputs.Brake) || Inputs.Handbrake;
+}
+
+float AVehicleSystemBase::GetSimulationLODDistance() const
+{
+	if( IsPlayerControlled() ) return 0.0f;
+	return GetNearestViewerDistance();
+}
+
+EVehicleSimulationLOD AVehicleSystemBase::GetDesiredSimulationLOD(float ViewerDistance) const
+{
+	// Coming back to a finer LOD needs the viewer to be closer than the distance it was left at
+	const float LOD1Distance = SimulationLOD1Distance - ((SimulationLOD != EVehicleSimulationLOD::LOD0) ? SimulationLODHysteresis : 0.0f);
+	const float LOD2Distance = SimulationLOD2Distance - ((SimulationLOD == EVehicleSimulationLOD::LOD2) ? SimulationLODHysteresis : 0.0f);
+
+	if( ViewerDistance >= LOD2Distance && CanSimulateKinematic() ) return EVehicleSimulationLOD::LOD2;
+	if( ViewerDistance >= LOD1Distance ) return EVehicleSimulationLOD::LOD1;
+	return EVehicleSimulationLOD::LOD0;
+}
+
+bool AVehicleSystemBase::CanSimulateKinematic() const
+{
+	if( !HasAuthority() || IsPlayerControlled() ) return false;
+
+	for( const UVehicleWheelBase* Wheel : VehicleWheels )
+	{
+		if( IsValid(Wheel) && Wheel->WheelConfig.WheelMode == EWheelMode::Physics ) return false;
+	}
+	return true;
+}
+
+void AVehicleSystemBase::SetSimulationLOD(EVehicleSimulationLOD NewSimulationLOD)
+{
+	if( NewSimulationLOD == SimulationLOD ) return;
+
+	if( NewSimulationLOD == EVehicleSimulationLOD::LOD2 )
+	{
+		FHitResult GroundHit;
+		if( !TraceKinematicGround(GetActorLocation(), 1000.0f, GroundHit) ) return; // Airborne, keep simulating
+
+		KinematicVelocity = VehicleMesh->GetPhysicsLinearVelocity();
+		KinematicGroundNormal = GroundHit.ImpactNormal;
+		KinematicRideHeight = GroundHit.Distance;
+		KinematicSnapTimer = 0.0f;
+		VehicleMesh->SetSimulatePhysics(false);
+	}
+	else if( SimulationLOD == EVehicleSimulationLOD::LOD2 )
+	{
+		VehicleMesh->SetSimulatePhysics(true);
+		VehicleMesh->SetPhysicsLinearVelocity(KinematicVelocity);
+		TeleportWheels();
+	}
+
+	SimulationLOD = NewSimulationLOD;
+	SimulationLODChanged(NewSimulationLOD);
+}
+
+FVector AVehicleSystemBase::GetVehicleVelocity() const
+{
+	// The body doesn't simulate in LOD2, the vehicle moves along the ground plane at the kinematic speed
+	if( SimulationLOD == EVehicleSimulationLOD::LOD2 ) return FVector::VectorPlaneProject(KinematicVelocity, KinematicGroundNormal).GetSafeNormal() * KinematicVelocity.Size();
+	return VehicleMesh->GetPhysicsLinearVelocity();
+}
+
+bool AVehicleSystemBase::TraceKinematicGround(const FVector& Location, float MaxDistance, FHitResult& OutHit) const
+{
+	// Hits what the wheel traces hit, on the first wheel's channel and ignoring what any wheel ignores
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(AVS_KinematicGround), false, this);
+	TOptional<ECollisionChannel> TraceChannel;
+	for( const UVehicleWheelBase* Wheel : VehicleWheels )
+	{
+		if( !IsValid(Wheel) ) continue;
+		if( IsValid(Wheel->WheelConfig.WheelPrim) ) QueryParams.AddIgnoredComponent(Wheel->WheelConfig.WheelPrim);
+		QueryParams.AddIgnoredActors(Wheel->WheelConfig.TraceIgnoreActors);
+		if( !TraceChannel.IsSet() ) TraceChannel = Wheel->WheelConfig.TraceChannel.GetValue();
+	}
+	return GetWorld()->LineTraceSingleByChannel(OutHit, Location, Location - FVector::UpVector * MaxDistance, TraceChannel.Get(ECC_Vehicle), QueryParams);
+}
+
+void AVehicleSystemBase::KinematicTick(float DeltaTime)
+{
+	FVector Location = GetActorLocation();
+	FRotator Rotation = GetActorRotation();
+	const float Speed = KinematicVelocity.Size();
+
+	// Steer towards the next path point at a constant speed, without a path keep going straight
+	if( KinematicPath.IsValidIndex(KinematicPathIndex) )
+	{
+		const FVector ToTarget = FVector::VectorPlaneProject(KinematicPath[KinematicPathIndex] - Location, FVector::UpVector);
+		if( ToTarget.SizeSquared() <= FMath::Square(FMath::Max(Speed * DeltaTime, 100.0f)) )
+		{
+			++KinematicPathIndex;
+		}
+		else
+		{
+			Rotation.Yaw = ToTarget.Rotation().Yaw;
+			KinematicVelocity = Rotation.Vector() * Speed;
+		}
+	}
+	Location += FVector::VectorPlaneProject(KinematicVelocity, KinematicGroundNormal).GetSafeNormal() * Speed * DeltaTime;
+
+	// Snap to the ground now and then, in between the vehicle moves along the last ground plane
+	KinematicSnapTimer += DeltaTime;
+	if( KinematicSnapTimer >= KinematicGroundSnapInterval )
+	{
+		KinematicSnapTimer = 0.0f;
+
+		FHitResult GroundHit;
+		const FVector TraceStart = Location + FVector::UpVector * KinematicRideHeight;
+		if( TraceKinematicGround(TraceStart, KinematicRideHeight * 3.0f, GroundHit) )
+		{
+			Location.Z = GroundHit.ImpactPoint.Z + KinematicRideHeight;
+			KinematicGroundNormal = GroundHit.ImpactNormal;
+			Rotation = FRotationMatrix::MakeFromZX(KinematicGroundNormal, Rotation.Vector()).Rotator();
+		}
+		else
+		{
+			SetSimulationLOD(EVehicleSimulationLOD::LOD1); // Lost the ground, let physics take over
+			return;
+		}
+	}
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	// Roll the wheels with the movement
+	const float ForwardSpeed = FVector::DotProduct(KinematicVelocity, GetActorForwardVector());
+	for( UVehicleWheelBase* Wheel : VehicleWheels )
+	{
+		if( IsValid(Wheel) ) Wheel->WheelData.AngularVelocity = ForwardSpeed / FMath::Max(Wheel->WheelConfig.WheelRadius, 1.0f);
+	}
+}
+
 // Tick that uses minimal resources
 void AVehicleSystemBase::PassiveTick(float DeltaTime)
 {
@@ -246,7 +607,7 @@ void AVehicleSystemBase::Tick(float DeltaTime)
 void AVehicleSystemBase::NetworkTick()
 {
 	NetworkRoles CurrentRole = GetNetworkRole();
-	if( CurrentRole != NetworkRoles::Owner )
+	if( CurrentRole != NetworkRoles::Owner && !IsServerSimulated() )
 	{
 		if (ReplicateMovement && ShouldSyncWithServer)
 		{
@@ -282,21 +643,81 @@ void AVehicleSystemBase::UpdateInternalWheelArray()
 			VehicleWheels.Add(CurWheel);
 		}
 	}
+
+	if( IsValid(WheelInstances) ) SetWheelInstances(WheelInstances); // Assign the new wheels their instances
+}
+
+void AVehicleSystemBase::SetWheelInstances(UInstancedStaticMeshComponent* NewWheelInstances)
+{
+	// Restore the wheel meshes
+	if( IsValid(WheelInstances) ) WheelInstances->ClearInstances();
+	WheelInstanceTransforms.Reset();
+	for( UVehicleWheelBase* Wheel : VehicleWheels )
+	{
+		if( !IsValid(Wheel) || Wheel->VisualInstanceIndex == INDEX_NONE ) continue;
+
+		Wheel->VisualInstanceIndex = INDEX_NONE;
+		Wheel->ResetVisual();
+		if( IsValid(Wheel->WheelMeshComponent) ) Wheel->WheelMeshComponent->SetVisibility(true);
+	}
+
+	WheelInstances = NewWheelInstances;
+	if( !IsValid(WheelInstances) ) return;
+
+	for( UVehicleWheelBase* Wheel : VehicleWheels )
+	{
+		if( !IsValid(Wheel) || !IsValid(Wheel->WheelMeshComponent) || Wheel->GetWheelMode() != EWheelMode::Raycast ) continue;
+
+		const FTransform InstanceTransform = Wheel->WheelMeshComponent->GetComponentTransform().GetRelativeTransform(WheelInstances->GetComponentTransform());
+		Wheel->VisualInstanceIndex = WheelInstanceTransforms.Add(InstanceTransform);
+		Wheel->ResetVisual();
+		Wheel->WheelMeshComponent->SetVisibility(false);
+	}
+	WheelInstances->AddInstances(WheelInstanceTransforms, false, false);
+}
+
+void AVehicleSystemBase::UpdateWheelVisuals(float DeltaTime)
+{
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_WheelVisuals);
+	bool bInstancesChanged = false;
+	for( UVehicleWheelBase* Wheel : VehicleWheels )
+	{
+		if( !IsValid(Wheel) ) continue;
+
+		FTransform RelativeTransform;
+		if( !Wheel->UpdateVisual(DeltaTime, RelativeTransform) ) continue;
+
+		if( WheelInstanceTransforms.IsValidIndex(Wheel->VisualInstanceIndex) )
+		{
+			WheelInstanceTransforms[Wheel->VisualInstanceIndex] = RelativeTransform * Wheel->GetComponentTransform().GetRelativeTransform(WheelInstances->GetComponentTransform());
+			bInstancesChanged = true;
+		}
+		else
+		{
+			Wheel->WheelMeshComponent->SetRelativeLocationAndRotation(RelativeTransform.GetLocation(), RelativeTransform.GetRotation());
+		}
+	}
+
+	// Every instanced wheel in a single render state update
+	if( bInstancesChanged && IsValid(WheelInstances) )
+	{
+		WheelInstances->BatchUpdateInstancesTransforms(0, WheelInstanceTransforms, false, true, true);
+	}
 }
 
 bool AVehicleSystemBase::IsPhysicsCallbackRegistered()
 {
-	return PhysicsThreadCallback != nullptr;
+	return VehicleSimulationId != INDEX_NONE;
 }
 
 void AVehicleSystemBase::RegisterPhysicsCallback()
 {
 	if (UWorld* World = GetWorld())
 	{
-		if (FPhysScene* PhysScene = World->GetPhysicsScene())
+		VehicleSimulation = World->GetSubsystem<UVehicleSimulationSubsystem>();
+		if (VehicleSimulation)
 		{
-			PhysicsThreadCallback = PhysScene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FVehiclePhysicsCallback>(); // Unreal 5.1+
-			PhysicsThreadCallback->VehicleMesh = VehicleMesh->GetBodyInstance()->GetPhysicsActorHandle();
+			VehicleSimulationId = VehicleSimulation->RegisterVehicle(this);
 			VehicleMesh->GetBodyInstance()->SetContactModification(true);
 		}
 	}
@@ -332,31 +753,72 @@ void AVehicleSystemBase::SetReplicationTimer(bool Enabled)
 	}
 }
 
+// Size of the state on the wire, only measured for the avs.Stats counters
+static int32 GetNetStateBytes(FNetState State)
+{
+	FBitWriter Writer(0, true);
+	bool bSuccess = true;
+	State.NetSerialize(Writer, nullptr, bSuccess);
+	return static_cast<int32>(Writer.GetNumBytes());
+}
+
 void AVehicleSystemBase::NetStateSend()
 {
-	if (GetNetworkRole() == NetworkRoles::Owner)
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_NetStateSend);
+	if( IsNetStateSender() )
 	{
 		FNetState NewState = CreateNetStateForNow();
 
 		// Only send while not at rest
 		if (!LocalVehicleAtRest) // Not at rest
 		{
-			Server_ReceiveNetState(NewState); // Send moving state
-			if (NetworkAtRest) // NetRest is resting but should not be
+			if( ShouldSendNetState(NewState) ) // Adaptive send rate skips states nobody needs yet
 			{
-				FNetState BlankRestState;
-				Server_ReceiveRestState(BlankRestState); // Reset NetRest
+				// Deltas against the last keyframe are a fraction of the size
+				NewState.Sequence = ++NetSendSequence;
+				LastSentState = NewState;
+				if( IsServerSimulated() && LastProcessedInputFrame > 0 ) // Owner compares against its prediction of the same input frame
+				{
+					FNetState Correction = LastProcessedState;
+					Correction.NetTimestamp = NewState.NetTimestamp;
+					Correction.Sequence = NewState.Sequence;
+					Correction.KeyframeSequence = Correction.Sequence;
+					Client_ReceiveCorrection(Correction, LastProcessedInputFrame);
+					AVS_COUNTER_ADD(BytesSent, GetNetStateBytes(Correction));
+				}
+				const bool bKeyframeDue = static_cast<uint16>(NetSendSequence - LastSentKeyframe.Sequence) >= NetKeyframeInterval
+					|| NewState.NetTimestamp - LastSentKeyframe.NetTimestamp >= FMath::Min(NetKeyframeMaxInterval, 0.5f);
+				if( SendKeyframe || bKeyframeDue )
+				{
+					NewState.KeyframeSequence = NewState.Sequence;
+					LastSentKeyframe = NewState;
+					SendKeyframe = false;
+				}
+				else
+				{
+					NewState.MakeDelta(LastSentKeyframe);
+				}
+
+				SendNetState(NewState); // Send moving state
+				AVS_COUNTER_ADD(BytesSent, GetNetStateBytes(NewState));
+				if (NetworkAtRest) // NetRest is resting but should not be
+				{
+					FNetState BlankRestState;
+					SendRestState(BlankRestState); // Reset NetRest
+				}
 			}
 		}
 		else // Is at rest
 		{
+			SendKeyframe = true; // Start moving with a keyframe
 			// NetworkAtRest is not true but should be, or distance is too different
 			const float DistanceThreshold = VehicleMesh->RigidBodyIsAwake() ? 50.0f : 0.5f; // Greater threshold if physics is awake to prevent constantly syncing
 			const float MoveDistance = UVehicleSystemFunctions::FastDist(RestState.position, NewState.position);
 			if( !NetworkAtRest || MoveDistance > DistanceThreshold )
 			{
 				UAVS_DEBUG::SCREEN(EDebugCategory::NETWORK, TXT("%s -- Update RestState // Dist %f > DistThreshold %f", *GetFName().ToString(), MoveDistance, DistanceThreshold));
-				Server_ReceiveRestState(NewState);
+				SendRestState(NewState);
+				AVS_COUNTER_ADD(BytesSent, GetNetStateBytes(NewState));
 			}
 		}
 
@@ -373,8 +835,8 @@ FNetState AVehicleSystemBase::CreateNetStateForNow()
 	FTransform primTransform = VehicleMesh->GetComponentToWorld();
 	newState.position = primTransform.GetLocation();
 	newState.rotation = primTransform.GetRotation().Rotator();
-	newState.velocity = VehicleMesh->GetPhysicsLinearVelocity();
-	newState.angularVelocity = VehicleMesh->GetPhysicsAngularVelocityInDegrees();
+	newState.velocity = GetVehicleVelocity();
+	newState.angularVelocity = SimulationLOD == EVehicleSimulationLOD::LOD2 ? FVector::ZeroVector : VehicleMesh->GetPhysicsAngularVelocityInDegrees();
 	newState.NetTimestamp = GetNetworkWorldTime();
 	return newState;
 }
@@ -385,6 +847,31 @@ bool AVehicleSystemBase::Server_ReceiveNetState_Validate(FNetState State)
 }
 void AVehicleSystemBase::Server_ReceiveNetState_Implementation(FNetState State)
 {
+	if( IsServerSimulated() ) return; // Server sends its own states, the owner only sends inputs
+
+	if( !ValidateNetState(State) )
+	{
+		RejectNetState();
+		return;
+	}
+
+	RelayNetState(State);
+}
+
+void AVehicleSystemBase::SendNetState(const FNetState& State)
+{
+	// The server doesn't call its own RPC, any state it receives while simulating came from the owner
+	if( IsServerSimulated() ) RelayNetState(State);
+	else Server_ReceiveNetState(State);
+}
+
+void AVehicleSystemBase::RelayNetState(const FNetState& State)
+{
+	UpdateNetSendInterval(State);
+
+	// Batched per connection by the simulation subsystem at the end of the frame
+	if( IsValid(VehicleSimulation) && VehicleSimulation->QueueNetStateRelay(this, State) ) return;
+
 	Client_ReceiveNetState(State);
 }
 
@@ -394,19 +881,421 @@ bool AVehicleSystemBase::Client_ReceiveNetState_Validate(FNetState State)
 }
 void AVehicleSystemBase::Client_ReceiveNetState_Implementation(FNetState State)
 {
+	ReceiveNetState(State);
+}
+
+void AVehicleSystemBase::ReceiveNetState(FNetState State)
+{
+	if( !ResolveNetState(State) ) return; // Keyframe was lost, wait for the next one
+
 	if(ShouldSyncWithServer)
 	{
 		AddStateToQueue(State);
 	}
 }
 
+bool AVehicleSystemBase::ResolveNetState(FNetState& State, TArray<FNetState, TInlineAllocator<4>>& Keyframes)
+{
+	if( State.IsKeyframe() )
+	{
+		AddNetStateKeyframe(State, Keyframes);
+		return true;
+	}
+	return ApplyNetStateKeyframe(State, Keyframes);
+}
+
+bool AVehicleSystemBase::ApplyNetStateKeyframe(FNetState& State, const TArray<FNetState, TInlineAllocator<4>>& Keyframes)
+{
+	if( State.IsKeyframe() ) return true;
+	if( State.NetTimestamp > MaxNetKeyframeAge ) return false; // Its keyframe was lost, a kept one with the same sequence is stale
+
+	for( const FNetState& Keyframe : Keyframes )
+	{
+		if( Keyframe.Sequence == State.KeyframeSequence )
+		{
+			State.ApplyDelta(Keyframe);
+			return true;
+		}
+	}
+	return false;
+}
+
+void AVehicleSystemBase::AddNetStateKeyframe(const FNetState& Keyframe, TArray<FNetState, TInlineAllocator<4>>& Keyframes)
+{
+	if( Keyframes.Num() == 4 ) Keyframes.RemoveAt(0, 1, EAllowShrinking::No);
+	Keyframes.Add(Keyframe);
+}
+
+// Owner input RPC: the new frames and the two sent before them (the last three when one frame is new), so a lost packet is covered by the next one
+static constexpr int32 MaxSentInputFrames = 16;
+
+// Body state a physics thread input record ended with
+static FNetState MakeInputFrameState(const FVehiclePhysicsInputRecord& Record)
+{
+	FNetState State;
+	State.position = Record.Position;
+	State.rotation = Record.Rotation.Rotator();
+	State.velocity = Record.Velocity;
+	State.angularVelocity = FMath::RadiansToDegrees(Record.AngularVelocity);
+	return State;
+}
+
+void AVehicleSystemBase::SetPhysicsInputFrames(FVehiclePhysicsVehicleInput& PhysicsInput)
+{
+	PhysicsInput.InputFrameEpoch = InputFrameEpoch;
+	PhysicsInput.InputFrames.Reset();
+	if( IsServerSimulated() )
+	{
+		PhysicsInput.InputFrameMode = EVehicleInputFrames::Replay;
+		PhysicsInput.InputFrames.Append(ServerInputQueue); // Resent until the physics thread reports them queued
+	}
+	else
+	{
+		PhysicsInput.InputFrameMode = IsPredictingOwner() ? EVehicleInputFrames::Predict : EVehicleInputFrames::None;
+		PhysicsInput.InputHistorySize = NetInputHistorySize;
+		PhysicsInput.CorrectionId = CorrectionId;
+		PhysicsInput.Correction = PendingCorrection;
+	}
+}
+
+void AVehicleSystemBase::RecordPredictedFrames(const FVehiclePhysicsVehicleOutput& PhysicsOutput)
+{
+	const int32 HistorySize = FMath::Max(NetInputHistorySize, 1);
+	if( PredictionHistory.Num() != HistorySize )
+	{
+		PredictionHistory.Reset();
+		PredictionHistory.SetNum(HistorySize);
+	}
+
+	// One frame per substep, a frame's state arrives with the output of the substep after it.
+	// States simulated before the physics thread replayed the last correction are stale
+	AppliedCorrectionId = PhysicsOutput.CorrectionId;
+	const bool bReplayed = AppliedCorrectionId == CorrectionId;
+	const uint32 LastSentFrame = InputFrame;
+	for( const FVehiclePhysicsInputRecord& Record : PhysicsOutput.InputRecords )
+	{
+		FAVS_PredictedFrame& Predicted = PredictionHistory[Record.Frame % HistorySize];
+		if( Record.Frame > InputFrame )
+		{
+			Predicted.Frame = Record.Frame;
+			Predicted.Inputs = Record.Inputs;
+			Predicted.bPredicted = false;
+			InputFrame = Record.Frame;
+		}
+		if( bReplayed && Record.bComplete && Predicted.Frame == Record.Frame && !Predicted.bPredicted )
+		{
+			Predicted.State = MakeInputFrameState(Record);
+			Predicted.bPredicted = true;
+		}
+	}
+	if( InputFrame == LastSentFrame ) return;
+
+	const uint32 NumFrames = FMath::Min<uint32>(InputFrame - LastSentFrame + 2, MaxSentInputFrames);
+	TArray<FAVS_InputFrame> Inputs;
+	Inputs.Reserve(NumFrames);
+	for( uint32 Frame = InputFrame - FMath::Min<uint32>(InputFrame - 1, NumFrames - 1); Frame <= InputFrame; ++Frame )
+	{
+		const FAVS_PredictedFrame& Recorded = PredictionHistory[Frame % HistorySize];
+		if( Recorded.Frame == Frame ) Inputs.Add({ Frame, Recorded.Inputs });
+	}
+	Server_ReceiveInputs(Inputs);
+}
+
+void AVehicleSystemBase::ConsumeServerFrames(const FVehiclePhysicsVehicleOutput& PhysicsOutput)
+{
+	if( PhysicsOutput.InputFrameEpoch != InputFrameEpoch ) return; // Simulated for the previous owner
+
+	// Frames the physics thread holds aren't resent
+	int32 NumQueued = 0;
+	while( NumQueued < ServerInputQueue.Num() && ServerInputQueue[NumQueued].Frame <= PhysicsOutput.LastQueuedInputFrame ) ++NumQueued;
+	ServerInputQueue.RemoveAt(0, NumQueued, EAllowShrinking::No);
+
+	// Corrections are sent for the newest frame whose state is known
+	for( int32 Index = PhysicsOutput.InputRecords.Num() - 1; Index >= 0; --Index )
+	{
+		const FVehiclePhysicsInputRecord& Record = PhysicsOutput.InputRecords[Index];
+		if( !Record.bComplete ) continue;
+		if( Record.Frame > LastProcessedInputFrame )
+		{
+			LastProcessedInputFrame = Record.Frame;
+			LastProcessedState = MakeInputFrameState(Record);
+		}
+		break;
+	}
+}
+
+void AVehicleSystemBase::ResetPrediction()
+{
+	InputFrame = 0;
+	PredictionHistory.Reset();
+	ServerInputQueue.Reset();
+	LastReceivedInputFrame = 0;
+	LastProcessedInputFrame = 0;
+	LastProcessedState = FNetState();
+	PendingCorrection = FVehiclePhysicsInputRecord(); // Frame 0 is never recorded
+	AppliedCorrectionId = CorrectionId;
+	++InputFrameEpoch;
+}
+
+bool AVehicleSystemBase::Server_ReceiveInputs_Validate(const TArray<FAVS_InputFrame>& Inputs)
+{
+	return Inputs.Num() <= MaxSentInputFrames;
+}
+void AVehicleSystemBase::Server_ReceiveInputs_Implementation(const TArray<FAVS_InputFrame>& Inputs)
+{
+	const int32 MaxQueuedFrames = FMath::Max(NetInputHistorySize, MaxSentInputFrames);
+	for( const FAVS_InputFrame& Input : Inputs )
+	{
+		if( Input.Frame + MaxQueuedFrames < LastReceivedInputFrame ) ResetPrediction(); // Owner's physics state restarted its frames
+		if( Input.Frame <= LastReceivedInputFrame ) continue; // Repeated or out of order
+		ServerInputQueue.Add({ Input.Frame, SanitizeServerInputs(Input.Inputs) });
+		LastReceivedInputFrame = Input.Frame;
+	}
+
+	// Only grows while the physics thread doesn't simulate the vehicle, the oldest frames are dropped
+	if( ServerInputQueue.Num() > MaxQueuedFrames ) ServerInputQueue.RemoveAt(0, ServerInputQueue.Num() - MaxQueuedFrames, EAllowShrinking::No);
+}
+
+FAVS_Inputs AVehicleSystemBase::SanitizeServerInputs(const FAVS_Inputs& Inputs) const
+{
+	// NaN fails every comparison and would pass a clamp, it becomes no input
+	auto ClampInput = [](float Value, float Min, float Max) { return FMath::IsFinite(Value) ? FMath::Clamp(Value, Min, Max) : 0.0f; };
+
+	FAVS_Inputs Sanitized = Inputs;
+	Sanitized.Steering = ClampInput(Inputs.Steering, -1.0f, 1.0f);
+	Sanitized.Throttle = ClampInput(Inputs.Throttle, -1.0f, 1.0f);
+	Sanitized.Brake = ClampInput(Inputs.Brake, 0.0f, 1.0f);
+	Sanitized.Torque = ClampInput(Inputs.Torque, 0.0f, NetMaxInputTorque > 0.0f ? NetMaxInputTorque : TNumericLimits<float>::Max());
+	return Sanitized;
+}
+
+void AVehicleSystemBase::Client_ReceiveCorrection_Implementation(FNetState State, uint32 Frame)
+{
+	if( !IsPredictingOwner() || PredictionHistory.Num() == 0 ) return;
+	if( AppliedCorrectionId != CorrectionId ) return; // Still replaying the previous one, later predictions are unknown until then
+
+	FAVS_PredictedFrame& Predicted = PredictionHistory[Frame % PredictionHistory.Num()];
+	if( Predicted.Frame != Frame || !Predicted.bPredicted ) return; // Older than the history, or not predicted yet
+	if( FVector::DistSquared(Predicted.State.position, State.position) <= FMath::Square(NetReconcileTolerance) ) return;
+
+	// The physics thread sets the body to the server state and replays the recorded frames since then (see FVehiclePhysicsCallback::ReplayCorrection)
+	PendingCorrection.Frame = Frame;
+	PendingCorrection.Position = State.position;
+	PendingCorrection.Rotation = State.rotation.Quaternion();
+	PendingCorrection.Velocity = State.velocity;
+	PendingCorrection.AngularVelocity = FMath::DegreesToRadians(State.angularVelocity);
+	PendingCorrection.bComplete = true;
+	++CorrectionId;
+
+	// Later predictions are replaced by the replayed states
+	const FVector PositionCorrection = State.position - Predicted.State.position;
+	Predicted.State = State;
+	for( FAVS_PredictedFrame& Later : PredictionHistory )
+	{
+		if( Later.Frame > Frame ) Later.bPredicted = false;
+	}
+	JitterBufferStats.NetError = PositionCorrection.Size();
+	UAVS_DEBUG::SCREEN(EDebugCategory::NETWORK, TXT("%s -- Reconciled frame %u // Error %f", *GetFName().ToString(), Frame, JitterBufferStats.NetError));
+}
+
+bool AVehicleSystemBase::ShouldSendNetState(const FNetState& State) const
+{
+	if( !NetAdaptiveSendRate || SendKeyframe || NetSendInterval <= NetSendRate ) return true;
+
+	const float TimeSinceSend = State.NetTimestamp - LastSentState.NetTimestamp;
+	if( TimeSinceSend >= NetSendInterval - NetSendRate * 0.5f ) return true; // Half a timer step early rather than a full step late
+
+	// Send early once the last sent state no longer predicts where we are
+	const FVector PredictedPosition = LastSentState.position + LastSentState.velocity * TimeSinceSend;
+	return FVector::DistSquared(PredictedPosition, State.position) > FMath::Square(NetSendErrorTolerance);
+}
+
+void AVehicleSystemBase::UpdateNetSendInterval(const FNetState& State)
+{
+	if( !NetAdaptiveSendRate )
+	{
+		NetSendInterval = 0.0f;
+		return;
+	}
+
+	const float MaxSendRate = 1.0f / FMath::Max(NetSendRate, UE_KINDA_SMALL_NUMBER);
+	const float MinSendRate = FMath::Clamp(NetMinSendRate, UE_KINDA_SMALL_NUMBER, MaxSendRate);
+
+	// Fast or spinning vehicles close to a viewer get the most states. Velocities are absolute in deltas too
+	const float Motion = FMath::Max(State.velocity.Size() / FMath::Max(NetMaxRateSpeed, 1.0f), State.angularVelocity.Size() / FMath::Max(NetMaxRateAngularSpeed, 1.0f));
+	const float Relevancy = 1.0f - FMath::Clamp(GetNearestViewerDistance() / FMath::Max(NetRelevancyDistance, 1.0f), 0.0f, 1.0f);
+	float SendRate = FMath::Lerp(MinSendRate, MaxSendRate, FMath::Clamp(Motion, 0.0f, 1.0f) * Relevancy);
+
+	if( IsValid(VehicleSimulation) )
+	{
+		VehicleSimulation->SetNetSendRate(VehicleSimulationId, SendRate);
+		SendRate = FMath::Max(SendRate * VehicleSimulation->GetNetSendBudgetScale(), MinSendRate);
+	}
+	NetSendInterval = 1.0f / SendRate;
+}
+
+float AVehicleSystemBase::GetNearestViewerDistance() const
+{
+	const FVector VehicleLocation = GetActorLocation();
+	float NearestDistanceSquared = TNumericLimits<float>::Max();
+	for( FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator )
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if( PlayerController == nullptr || PlayerController == GetController() ) continue; // Owner doesn't use its own states
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		NearestDistanceSquared = FMath::Min(NearestDistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, VehicleLocation)));
+	}
+	return FMath::Sqrt(NearestDistanceSquared);
+}
+
+bool AVehicleSystemBase::ValidateNetState(const FNetState& State)
+{
+	// Only states sent by a client are checked
+	if( !NetValidateMovement || GetNetworkRole() != NetworkRoles::Server ) return true;
+
+	// Keyframes are only kept once accepted, deltas never resolve against a rejected position
+	FNetState Absolute = State;
+	if( !ApplyNetStateKeyframe(Absolute, ValidationKeyframes) ) return true; // Receivers drop it too
+
+	if( Absolute.position.ContainsNaN() || Absolute.velocity.ContainsNaN() || Absolute.angularVelocity.ContainsNaN() || !FMath::IsFinite(Absolute.NetTimestamp) ) return false;
+
+	const float MaxGearSpeed = GetMaxGearSpeed();
+	if( MaxGearSpeed > 0.0f && Absolute.velocity.SizeSquared() > FMath::Square(MaxGearSpeed * NetSpeedTolerance) ) return false;
+
+	if( HasAcceptedState )
+	{
+		// Repeated or stale timestamps are rejected, the bounds use server time so future timestamps can't widen them
+		if( Absolute.NetTimestamp <= LastAcceptedState.NetTimestamp ) return false;
+		const float DeltaTime = ConsumeValidationTime(Absolute.NetTimestamp - LastAcceptedState.NetTimestamp);
+
+		if( (Absolute.velocity - LastAcceptedState.velocity).SizeSquared() > FMath::Square(NetMaxAcceleration * DeltaTime) ) return false;
+
+		const FVector PredictedPosition = LastAcceptedState.position + (LastAcceptedState.velocity + Absolute.velocity) * 0.5f * DeltaTime;
+		if( FVector::DistSquared(PredictedPosition, Absolute.position) > FMath::Square(NetMaxTeleportDistance) ) return false;
+	}
+	else
+	{
+		if( !IsReachableFromServerBody(Absolute) ) return false;
+		LastValidationTime = GetLocalWorldTime();
+		ValidationTimeBudget = 0.0f;
+	}
+
+	if( Absolute.IsKeyframe() ) AddNetStateKeyframe(Absolute, ValidationKeyframes);
+	LastAcceptedState = Absolute;
+	HasAcceptedState = true;
+	return true;
+}
+
+bool AVehicleSystemBase::IsReachableFromServerBody(const FNetState& State) const
+{
+	if( !IsValid(VehicleMesh) ) return false;
+
+	// The state's time relative to the body is unknown, the whole validation time is allowed either way
+	const FVector BodyPosition = VehicleMesh->GetComponentLocation();
+	const FVector BodyVelocity = GetVehicleVelocity();
+	const float DeltaTime = GetMaxValidationDeltaTime();
+
+	if( (State.velocity - BodyVelocity).SizeSquared() > FMath::Square(NetMaxAcceleration * DeltaTime) ) return false;
+
+	const float MaxTravel = FMath::Max(BodyVelocity.Size(), State.velocity.Size()) * DeltaTime;
+	return FVector::DistSquared(BodyPosition, State.position) <= FMath::Square(NetMaxTeleportDistance + MaxTravel);
+}
+
+float AVehicleSystemBase::GetMaxGearSpeed() const
+{
+	float MaxSpeed = 0.0f;
+	for( const FVehicleGear& Gear : Gears ) { MaxSpeed = FMath::Max(MaxSpeed, FMath::Abs(Gear.EndSpeed) * GearSpeedToCmPerSecond); }
+	return MaxSpeed;
+}
+
+float AVehicleSystemBase::ConsumeValidationTime(float ClientDeltaTime)
+{
+	// States sent together arrive together, the budget keeps the server time of earlier frames for them
+	const float CurrentTime = GetLocalWorldTime();
+	const float MaxDeltaTime = GetMaxValidationDeltaTime(); // A state per send interval has to fit
+	ValidationTimeBudget = FMath::Min(ValidationTimeBudget + FMath::Max(CurrentTime - LastValidationTime, 0.0f), MaxDeltaTime);
+	LastValidationTime = CurrentTime;
+
+	const float DeltaTime = FMath::Clamp(ClientDeltaTime, 0.0f, ValidationTimeBudget);
+	ValidationTimeBudget -= DeltaTime;
+	return DeltaTime;
+}
+
+void AVehicleSystemBase::RejectNetState()
+{
+	++NetValidationViolations;
+	NetStateRejected(NetValidationViolations);
+
+	// Owner is sent back to the last accepted state, or to the server's body before the first one, a few times a second at most
+	const float CurrentTime = GetLocalWorldTime();
+	if( (HasAcceptedState || IsValid(VehicleMesh)) && CurrentTime - LastCorrectionTime >= 0.25f )
+	{
+		LastCorrectionTime = CurrentTime;
+		FNetState Correction = HasAcceptedState ? LastAcceptedState : CreateNetStateForNow();
+		Correction.Sequence = Correction.KeyframeSequence = 0;
+		Client_CorrectNetState(Correction);
+	}
+	UAVS_DEBUG::SCREEN(EDebugCategory::NETWORK, TXT("%s -- Rejected client state // Violations %d", *GetFName().ToString(), NetValidationViolations));
+}
+
+void AVehicleSystemBase::Client_CorrectNetState_Implementation(FNetState State)
+{
+	if( GetNetworkRole() != NetworkRoles::Owner ) return;
+
+	ApplyExactNetState(State);
+	SendKeyframe = true;
+	LastSentState = State;
+}
+
 bool AVehicleSystemBase::Server_ReceiveRestState_Validate(FNetState State)
 {
 	return true;
 }
 void AVehicleSystemBase::Server_ReceiveRestState_Implementation(FNetState State)
+{
+	if( IsServerSimulated() ) return; // Server decides where the vehicle rests
+
+	// Resting somewhere the last accepted state can't reach
+	if( NetValidateMovement && HasAcceptedState && GetNetworkRole() == NetworkRoles::Server && State.position != FVector::ZeroVector )
+	{
+		// Same server time bounds as moving states, the timestamp has to move forward
+		const bool bValidTimestamp = FMath::IsFinite(State.NetTimestamp) && State.NetTimestamp > LastAcceptedState.NetTimestamp;
+		const float DeltaTime = bValidTimestamp ? ConsumeValidationTime(State.NetTimestamp - LastAcceptedState.NetTimestamp) : 0.0f;
+		const FVector PredictedPosition = LastAcceptedState.position + LastAcceptedState.velocity * 0.5f * DeltaTime;
+		if( !bValidTimestamp || State.position.ContainsNaN() || FVector::DistSquared(PredictedPosition, State.position) > FMath::Square(NetMaxTeleportDistance) )
+		{
+			RejectNetState();
+			return;
+		}
+		LastAcceptedState = State; // Later states are checked against the rest position
+		LastAcceptedState.velocity = FVector::ZeroVector;
+		LastAcceptedState.angularVelocity = FVector::ZeroVector;
+	}
+	else if( NetValidateMovement && GetNetworkRole() == NetworkRoles::Server && State.position != FVector::ZeroVector )
+	{
+		if( State.position.ContainsNaN() || !IsReachableFromServerBody(State) )
+		{
+			RejectNetState();
+			return;
+		}
+	}
+
+	StoreRestState(State);
+}
+
+void AVehicleSystemBase::SendRestState(const FNetState& State)
+{
+	if( IsServerSimulated() ) StoreRestState(State);
+	else Server_ReceiveRestState(State);
+}
+
+void AVehicleSystemBase::StoreRestState(const FNetState& State)
 {
 	RestState = State; // Clients should still receive even when not actively syncing
+	if( IsValid(VehicleSimulation) && State.position != FVector::ZeroVector ) VehicleSimulation->SetNetSendRate(VehicleSimulationId, 0.0f); // Resting vehicles only send on change
 	if(GetLocalRole() == ROLE_Authority) {OnRep_RestState();} //RepNotify on Server
 }
 
@@ -416,77 +1305,63 @@ bool AVehicleSystemBase::Multicast_ChangedOwner_Validate()
 }
 void AVehicleSystemBase::Multicast_ChangedOwner_Implementation()
 {
+	// Sequences of the new owner are unrelated to the old one
+	ReceivedKeyframes.Reset();
+	SendKeyframe = true;
 	ClearQueue();
+	ResetPrediction();
+	ValidationKeyframes.Reset();
+	HasAcceptedState = false;
 	OwnerChanged();
 }
 
 void AVehicleSystemBase::AddStateToQueue(FNetState StateToAdd)
 {
-	if (GetNetworkRole() != NetworkRoles::Owner)
+	if (GetNetworkRole() != NetworkRoles::Owner && !IsServerSimulated())
 	{
-		// If we have 10 or more states we are flooded and should drop new states
-		if (StateQueue.Num() < 10)
+		const int32 QueueCapacity = FMath::Max(NetQueueCapacity, 1);
+		if( StateQueue.GetCapacity() != QueueCapacity ) // Resized at runtime
 		{
-			StateToAdd.NetTimestamp += NetTimeBehind; //Change the timestamp to the future so we can lerp
+			ClearQueue();
+			StateQueue.SetCapacity(QueueCapacity);
+		}
 
-			if( StateToAdd.NetTimestamp < LastActiveTimestamp )
-			{
-				return; // This state is late and should be discarded
-			}
+		++JitterBufferStats.Received;
+		StateToAdd.NetTimestamp += NetTimeBehind; //Change the timestamp to the future so we can lerp
 
-			if (StateQueue.IsValidIndex(0))
-			{
-				int8 lastindex = StateQueue.Num() - 1;
-				for (int8 i = lastindex; i >= 0; --i)
-				{
-					if (StateQueue.IsValidIndex(i))
-					{
-						if( StateQueue[i].NetTimestamp < StateToAdd.NetTimestamp )
-						{
-							StateQueue.Insert(StateToAdd, i + 1);
-							CalculateTimestamps();
-							StateToAdd.LocalTimestamp = StateQueue[i + 1].NetTimestamp;
-							break;
-						}
-					}
-				}
-			}
-			else
-			{
-				StateToAdd.LocalTimestamp = GetLocalWorldTime() + NetTimeBehind;
-				StateQueue.Insert(StateToAdd, 0); // If the queue is empty just add it in the first spot
-			}
+		if( StateToAdd.NetTimestamp < LastActiveTimestamp )
+		{
+			++JitterBufferStats.LateDrops; // This state is late and should be discarded
+			return;
+		}
+
+		switch( StateQueue.Insert(StateToAdd, GetLocalWorldTime() + NetTimeBehind) )
+		{
+			case FNetStateQueue::EInsertResult::Added:
+				JitterBufferStats.MaxDepth = FMath::Max(JitterBufferStats.MaxDepth, StateQueue.Num());
+				break;
+			case FNetStateQueue::EInsertResult::Late:
+				++JitterBufferStats.LateDrops;
+				break;
+			case FNetStateQueue::EInsertResult::Overflow:
+				++JitterBufferStats.OverflowDrops; // Flooded, drop new states
+				break;
 		}
 	}
 }
 
 void AVehicleSystemBase::ClearQueue()
 {
-	StateQueue.Empty();
+	StateQueue.Reset();
 	CreateNewStartState = true;
-}
-
-void AVehicleSystemBase::CalculateTimestamps()
-{
-	int8 lastindex = StateQueue.Num() - 1;
-	for (int8 i = 0; i <= lastindex; i++)
-	{
-		// The first state is always our point of reference and should not change
-		// Especially since it could be actively syncing
-		if(i != 0)
-		{
-			if (StateQueue.IsValidIndex(i))
-			{
-				// Calculate the time difference in the owners times and apply it to our local times
-				float timeDifference = StateQueue[i].NetTimestamp - StateQueue[i - 1].NetTimestamp;
-				StateQueue[i].LocalTimestamp = StateQueue[i - 1].LocalTimestamp + timeDifference;
-			}
-		}
-	}
+	CanExtrapolate = false;
 }
 
 void AVehicleSystemBase::SyncPhysics()
 {
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_SyncPhysics);
+	AVS_COUNTER_ADD(QueueDepth, StateQueue.Num());
+
 	if( NetworkAtRest )
 	{
 		SetVehicleLocation(RestState.position, RestState.rotation, true);
@@ -503,14 +1378,20 @@ void AVehicleSystemBase::SyncPhysics()
 		return;
 	}
 
-	if (StateQueue.IsValidIndex(0))
+	if (!StateQueue.IsEmpty())
 	{
-		FNetState NextState = StateQueue[0];
+		FNetState NextState = StateQueue.GetFront();
 		float CurrentTime = GetLocalWorldTime();
 
 		// use physics until we are close enough to this timestamp
-		if( CurrentTime >= (NextState.LocalTimestamp - NetLerpStart) )
+		if( CurrentTime < (NextState.LocalTimestamp - NetLerpStart) )
 		{
+			ExtrapolateNetState(CurrentTime);
+		}
+		else
+		{
+			CanExtrapolate = false;
+
 			if (CreateNewStartState)
 			{
 				LerpStartState = CreateNetStateForNow();
@@ -522,10 +1403,11 @@ void AVehicleSystemBase::SyncPhysics()
                     FMath::IsNearlyEqual(LerpStartState.position.Y, NextState.position.Y, NetPositionTolerance) &&
                     FMath::IsNearlyEqual(LerpStartState.position.Z, NextState.position.Z, NetPositionTolerance))
 				{
-					StateQueue.RemoveAt(0);
+					StateQueue.PopFront();
 					CreateNewStartState = true;
 					return;
 				}
+				JitterBufferStats.NetError = FVector::Dist(LerpStartState.position, NextState.position);
 			}
 
 			LastActiveTimestamp = NextState.NetTimestamp;
@@ -534,18 +1416,60 @@ void AVehicleSystemBase::SyncPhysics()
 			// Our start state may have been created after the lerp start time, so choose whatever is latest
 			float lerpBeginTime = LerpStartState.NetTimestamp;
 			float lerpPercent = FMath::Clamp(GetPercentBetweenValues(CurrentTime, lerpBeginTime, NextState.LocalTimestamp), 0.0f, 1.0f);
-			FVector NewPosition = UKismetMathLibrary::VLerp(LerpStartState.position, NextState.position, lerpPercent);
-			FRotator NewRotation = UKismetMathLibrary::RLerp(LerpStartState.rotation, NextState.rotation, lerpPercent, true);
+			FVector NewPosition;
+			FRotator NewRotation;
+			InterpolateNetState(LerpStartState, NextState, lerpPercent, NextState.LocalTimestamp - lerpBeginTime, NewPosition, NewRotation);
 			SetVehicleLocation(NewPosition, NewRotation);
 
 			if( lerpPercent >= 0.99f || lerpBeginTime > NextState.LocalTimestamp )
 			{
 				ApplyExactNetState(NextState);
-				StateQueue.RemoveAt(0);
+				StateQueue.PopFront();
 				CreateNewStartState = true;
+				LastSyncedState = NextState;
+				CanExtrapolate = true;
 			}
 		}
 	}
+	else
+	{
+		ExtrapolateNetState(GetLocalWorldTime()); // Queue ran dry
+	}
+}
+
+void AVehicleSystemBase::InterpolateNetState(const FNetState& From, const FNetState& To, float Alpha, float Duration, FVector& OutPosition, FRotator& OutRotation) const
+{
+	if( NetInterpolation == NetInterpolationType::Hermite )
+	{
+		// Velocities are per second, the tangents are scaled to the length of the lerp. Clamped so a late start state can't overshoot
+		const float TangentScale = FMath::Clamp(Duration, 0.0f, NetLerpStart);
+		OutPosition = FMath::CubicInterp(From.position, From.velocity * TangentScale, To.position, To.velocity * TangentScale, Alpha);
+	}
+	else
+	{
+		OutPosition = UKismetMathLibrary::VLerp(From.position, To.position, Alpha);
+	}
+	OutRotation = UKismetMathLibrary::RLerp(From.rotation, To.rotation, Alpha, true);
+}
+
+bool AVehicleSystemBase::ExtrapolateNetState(float CurrentTime)
+{
+	if( !CanExtrapolate || NetMaxExtrapolationTime <= 0.0f ) return false;
+
+	const float ElapsedTime = CurrentTime - LastSyncedState.LocalTimestamp;
+	if( ElapsedTime > NetMaxExtrapolationTime )
+	{
+		CanExtrapolate = false; // Waited too long, leave it to physics
+		return false;
+	}
+
+	// Dead reckoning from the last synced state
+	const FVector NewPosition = LastSyncedState.position + LastSyncedState.velocity * ElapsedTime;
+	const FVector AngularVelocity = LastSyncedState.angularVelocity;
+	const FQuat Spin(AngularVelocity.GetSafeNormal(), FMath::DegreesToRadians(AngularVelocity.Size() * ElapsedTime));
+	const FRotator NewRotation = (Spin * LastSyncedState.rotation.Quaternion()).Rotator();
+	SetVehicleLocation(NewPosition, NewRotation);
+	return true;
 }
 
 void AVehicleSystemBase::LerpToNetState(FNetState NextState, float CurrentServerTime)
@@ -555,8 +1479,9 @@ void AVehicleSystemBase::LerpToNetState(FNetState NextState, float CurrentServer
 
 	float lerpPercent = FMath::Clamp(GetPercentBetweenValues(CurrentServerTime, lerpBeginTime, NextState.NetTimestamp), 0.0f, 1.0f);
 
-	FVector NewPosition = UKismetMathLibrary::VLerp(LerpStartState.position, NextState.position, lerpPercent);
-	FRotator NewRotation = UKismetMathLibrary::RLerp(LerpStartState.rotation, NextState.rotation, lerpPercent, true);
+	FVector NewPosition;
+	FRotator NewRotation;
+	InterpolateNetState(LerpStartState, NextState, lerpPercent, NextState.NetTimestamp - lerpBeginTime, NewPosition, NewRotation);
 	SetVehicleLocation(NewPosition, NewRotation);
 }
 
@@ -627,241 +1552,331 @@ void AVehicleSystemBase::SetVehicleLocation(const FVector& InNewPos, const FRota
 	}
 }
 
-void AVehicleSystemBase::AVS_PhysicsTick(float ChaosDelta, const FVehiclePhysicsPhysicsInput* PhysicsInput, FVehiclePhysicsPhysicsOutput& PhysicsOutput)
+void AVehicleSystemBase::AVS_GatherWheelQueries(const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState, FAVS_WheelQueryBatch& WheelQueries)
 {
-	using namespace Chaos;
+	const FTransform VehicleBodyTransform = UVehicleSystemFunctions::AVS_GetChaosTransform(PhysicsState.BodyHandle);
+	const FAVS_WheelSimData& Wheels = PhysicsInput.Wheels;
+	const TArray<FAVS_WheelColdData>& ColdWheels = PhysicsInput.ColdWheels->Wheels;
+	const int32 NumWheels = Wheels.Num();
 
-	UWorld* World = PhysicsInput->World.Get(); // only safe to access for scene queries
-	if( World == nullptr ) return;
-	
-	FTransform VehicleBodyTransform = UVehicleSystemFunctions::AVS_GetChaosTransform(PhysicsInput->VehicleMeshPrim);
-	TArray<FAVS1_Wheel_Config> Wheels = PhysicsInput->Wheels;
-	
-	if( WheelStates.Num() != Wheels.Num() ) { WheelStates.SetNum(Wheels.Num()); } // Ensure wheel state array is in sync
-	
-	// Loop through each wheel
-	for( int32 WIndex = 0; WIndex < Wheels.Num(); ++WIndex )
+	if( PhysicsState.WheelStates.Num() != NumWheels ) // Ensure wheel state arrays are in sync
+	{
+		PhysicsState.WheelStates.SetNum(NumWheels);
+		PhysicsState.ContactCaches.SetNum(NumWheels);
+	}
+
+	// Contacts are only reused while crawling, the rays are still checked per wheel
+	const FVector VehicleVelocity = UVehicleSystemFunctions::AVS_ChaosGetVelocityAtLocation(PhysicsState.BodyHandle, VehicleBodyTransform.GetLocation());
+	const bool bReuseContacts = PhysicsInput.ContactCacheTolerance > 0.0f && VehicleVelocity.SizeSquared() <= FMath::Square(PhysicsInput.ContactCacheMaxSpeed);
+
+	// LOD1 reuses the contacts of the previous substep every other substep, staggered by vehicle so the traces are spread out
+	const bool bSkipTraces = PhysicsInput.SimulationLOD == EVehicleSimulationLOD::LOD1 && ((PhysicsState.NumSubsteps + PhysicsInput.VehicleId) & 1) != 0;
+	++PhysicsState.NumSubsteps;
+
+	// Gather the rays of every wheel, they are resolved together with the other vehicles
+	PhysicsState.WheelWorldTransforms.Reset();
+	PhysicsState.WheelQueryIndices.Reset();
+	int32 ParamsIndex = INDEX_NONE;
+	for( int32 WIndex = 0; WIndex < NumWheels; ++WIndex )
 	{
-		FAVS1_Wheel_Output WheelOutput; // New output for this wheel
-		FAVS1_Wheel_Config WheelConfig = Wheels[WIndex]; // Current configuration from the game thread
-		FAVS1_Wheel_State& WheelState = WheelStates[WIndex]; // State data on the physics thread
+		const float SpringLength = Wheels.SpringLength[WIndex];
+		const float WheelRadius = Wheels.Radius[WIndex];
 
-		FTransform WheelLocalTransform = WheelConfig.WheelLocalTransform;
-		if(WheelConfig.IsSteerableWheel) // Steering
+		FTransform WheelLocalTransform = Wheels.LocalTransform[WIndex];
+		if( Wheels.HasFlag(WIndex, EAVS_WheelFlags::Steerable) ) // Steering
 		{
-			float SteeringAngle = PhysicsInput->VehicleInputs.Steering * WheelConfig.MaxSteeringAngle;
-			SteeringAngle = WheelConfig.InvertSteering ? (SteeringAngle * -1.0f) : SteeringAngle;
+			float SteeringAngle = PhysicsState.Inputs.Steering * Wheels.MaxSteeringAngle[WIndex];
+			SteeringAngle = Wheels.HasFlag(WIndex, EAVS_WheelFlags::InvertSteering) ? (SteeringAngle * -1.0f) : SteeringAngle;
 			WheelLocalTransform.SetRotation( WheelLocalTransform.TransformRotation(FRotator(0.0f, SteeringAngle, 0.0f).Quaternion()) );
 		}
 
 		// We have to calculate the wheel transform every frame because it doesn't have a body in the physics scene
-		FTransform WheelWorldTransform = FTransform( VehicleBodyTransform.TransformRotation(WheelLocalTransform.GetRotation()),
+		const FTransform& WheelWorldTransform = PhysicsState.WheelWorldTransforms.Emplace_GetRef( VehicleBodyTransform.TransformRotation(WheelLocalTransform.GetRotation()),
 			VehicleBodyTransform.TransformPosition(WheelLocalTransform.GetLocation()) );
+		const FVector WheelWorldLocation = WheelWorldTransform.GetLocation();
+		const FVector WheelWorldUp = WheelWorldTransform.GetUnitAxis( EAxis::Z );
+
+		FVector TraceStart = WheelWorldLocation + WheelWorldUp * (SpringLength*0.5f + WheelRadius); // Top of wheel while compressed
+		FVector TraceEnd = WheelWorldLocation - WheelWorldUp * (SpringLength*0.5f + WheelRadius); // Bottom of wheel while extended
+
+		const FAVS_WheelColdData& ColdWheel = ColdWheels[WIndex];
+		FAVS_WheelContactCache& ContactCache = PhysicsState.ContactCaches[WIndex];
+		const float ReuseTolerance = bSkipTraces ? (SpringLength + WheelRadius * 2.0f) : PhysicsInput.ContactCacheTolerance; // Skipped traces accept any ground the ray still crosses
+		if( !bReuseContacts && !bSkipTraces )
+		{
+			ContactCache.Invalidate();
+		}
+		else if( ContactCache.Reproject(TraceStart, TraceEnd, ReuseTolerance) ) // Ground has not changed, no trace needed
+		{
+			PhysicsState.WheelQueryIndices.Add(INDEX_NONE);
+			if( ColdWheel.bNewQueryParams ) ParamsIndex = INDEX_NONE; // Next wheel can't share the params of the previous one
+			continue;
+		}
+
+		// Wheels usually share the same ignore list, the cold block knows when new query params are needed
+		if( ParamsIndex == INDEX_NONE || ColdWheel.bNewQueryParams )
+		{
+			ParamsIndex = WheelQueries.AddQueryParams(PhysicsInput.VehicleActorId, ColdWheel.TraceIgnoreActorIds);
+		}
+		PhysicsState.WheelQueryIndices.Add(WheelQueries.AddQuery(TraceStart, TraceEnd, ColdWheel.TraceChannel, ParamsIndex));
+	}
+}
+
+void AVehicleSystemBase::AVS_PhysicsTick(float ChaosDelta, const UWorld* World, const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState,
+	const FAVS_WheelQueryBatch& WheelQueries, FAVS_WheelKernel& WheelKernel, FVehiclePhysicsVehicleOutput& PhysicsOutput)
+{
+	using namespace Chaos;
+	AVS_SCOPE_CYCLE_COUNTER(STAT_AVS_PhysicsTick);
+
+	const FAVS_WheelSimData& Wheels = PhysicsInput.Wheels;
+	const FAVS_Inputs& VehicleInputs = PhysicsState.Inputs; // Received frames replace the game thread inputs while the server simulates
+	const float AntiGravityN = (-World->GetGravityZ() * PhysicsInput.VehicleMass) * 0.01f; // Added to the spring while over compressed
+
+	// Outputs are written by wheel index, raycast wheels with a contact are finished in AVS_ApplyWheelKernel
+	PhysicsOutput.WheelOutputs.SetNum(Wheels.Num());
+	PhysicsState.FirstKernelLane = WheelKernel.NumLanes;
+	
+	// Loop through each wheel
+	for( int32 WIndex = 0; WIndex < Wheels.Num(); ++WIndex )
+	{
+		FAVS1_Wheel_Output& WheelOutput = PhysicsOutput.WheelOutputs[WIndex]; // New output for this wheel
+		FAVS1_Wheel_State& WheelState = PhysicsState.WheelStates[WIndex]; // State data on the physics thread
+
+		// Current configuration from the game thread
+		const float SpringLength = Wheels.SpringLength[WIndex];
+		const float BrakeTorque = Wheels.BrakeTorque[WIndex];
+		const EAVS_WheelFlags WheelFlags = Wheels.Flags[WIndex];
+		const EWheelMode WheelMode = EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::PhysicsMode) ? EWheelMode::Physics : EWheelMode::Raycast;
+		Chaos::FRigidBodyHandle_Internal* WheelHandle = PhysicsState.WheelHandles[WIndex];
+
+		const FTransform& WheelWorldTransform = PhysicsState.WheelWorldTransforms[WIndex];
 		FVector WheelWorldLocation = WheelWorldTransform.GetLocation();
-		FVector WheelWorldForward = WheelWorldTransform.GetUnitAxis( EAxis::X );
-		FVector WheelWorldRight = WheelWorldTransform.GetUnitAxis( EAxis::Y );
 		FVector WheelWorldUp = WheelWorldTransform.GetUnitAxis( EAxis::Z );
 
-		FVector TraceStart = WheelWorldLocation + WheelWorldUp * (WheelConfig.SpringLength*0.5f + WheelConfig.WheelRadius); // Top of wheel while compressed
-		FVector TraceEnd = WheelWorldLocation - WheelWorldUp * (WheelConfig.SpringLength*0.5f + WheelConfig.WheelRadius); // Bottom of wheel while extended
-		
-		FHitResult Trace;
-		bool TraceHit = UKismetSystemLibrary::LineTraceSingle(this, TraceStart, TraceEnd, UEngineTypes::ConvertToTraceType(WheelConfig.TraceChannel),
-															  true, WheelConfig.TraceIgnoreActors, EDrawDebugTrace::None, Trace, true);
-		AddDebugTrace(PhysicsOutput, Trace);
-		WheelOutput.LastTrace = Trace;
+		// Reused contacts were already moved onto this substep's ray, new traces refresh the cache
+		FAVS_WheelContactCache& ContactCache = PhysicsState.ContactCaches[WIndex];
+		const int32 QueryIndex = PhysicsState.WheelQueryIndices[WIndex];
+		if( QueryIndex != INDEX_NONE && (PhysicsInput.ContactCacheTolerance > 0.0f || PhysicsInput.SimulationLOD != EVehicleSimulationLOD::LOD0) ) ContactCache.Store(WheelQueries.Hits[QueryIndex]);
+		const FHitResult& Trace = (QueryIndex != INDEX_NONE) ? WheelQueries.Hits[QueryIndex] : ContactCache.Hit;
+		const bool TraceHit = (QueryIndex != INDEX_NONE) ? WheelQueries.HasBlockingHit(QueryIndex) : true;
+		AddTelemetryTrace(PhysicsState, WIndex, Trace, WheelMode);
+		WheelOutput.Contact = FAVS_WheelContact(Trace);
 		
 		if(TraceHit)
 		{
-			// Length of spring right now while compressed
-			float Length = Trace.Distance - (WheelConfig.WheelRadius * 2.0f);
-			float NewSpringLength = TraceHit ? FMath::Clamp(Length, 0.0f, WheelConfig.SpringLength) : WheelConfig.SpringLength;
-			WheelOutput.CurrentSpringLength = NewSpringLength; // Used by game thread to place wheel mesh
-			
-			// Wheel World and Contact Velocity
-			const FVector WheelVelocityWorld = UVehicleSystemFunctions::AVS_ChaosGetVelocityAtLocation(PhysicsInput->VehicleMeshPrim, Trace.ImpactPoint);
-			const FVector WheelVelocityLocal = WheelWorldTransform.Inverse().TransformVectorNoScale(WheelVelocityWorld);
-			//UPrimitiveComponent* ContactComponent = HitResult.GetComponent(); // Get the contact object //TODO :: Chaos Thread equivalent
-			const FVector ContactCompVelocityWorld = FVector::ZeroVector;//ContactComponent->GetPhysicsLinearVelocityAtPoint(ImpactPoint);
-			const FVector WheelVelocityWorldM = (WheelVelocityWorld - ContactCompVelocityWorld) * 0.01f; // Velocity relative to contacted object (Meters/Second)
-			const FVector WheelVelocityProjected = FVector::VectorPlaneProject(WheelVelocityWorldM, Trace.ImpactNormal); // Project speed onto plane
-			const FVector WheelVelocityLocalM = WheelWorldTransform.InverseTransformVectorNoScale(WheelVelocityProjected); // Wheel velocity relative to vehicle (Meters/Second)
-
-			// Project the axes onto the plane
-			FVector ForwardOnPlane = FVector::VectorPlaneProject(WheelWorldForward, Trace.ImpactNormal); ForwardOnPlane.Normalize();
-			FVector RightOnPlane = FVector::VectorPlaneProject(WheelWorldRight, Trace.ImpactNormal); RightOnPlane.Normalize();
-			const float WheelVelocity = WheelVelocityProjected.Size(); // Wheel velocity in Meters/Second
-			FVector LinearVelocityOnPlaneNormalized; if (WheelVelocity != 0.0f) LinearVelocityOnPlaneNormalized = WheelVelocityProjected / WheelVelocity;
-
-			// Suspension
-			const float SpringStrengthNm = WheelConfig.SpringStrength * 1000.0f; // Spring Strength in N/m
-			const float ShockAbsorption = WheelConfig.SpringDamping * 1000.0f; // Spring Damper in Ns/m
-			const float CompressionDistanceM = (WheelConfig.SpringLength - NewSpringLength) * 0.01f; // Distance of compression in Meters
-			const float CompressionVelocityM = WheelVelocityLocal.Z * (-0.01f); // Velocity of compression in Meters/Second
-
-			float SpringForceN = SpringStrengthNm * CompressionDistanceM;
-			float DamperForceN = ShockAbsorption * CompressionVelocityM;
-
-			// Suspension :: Excess compression
-			if( Length < -1.0f )
+			// Wheel World Velocity, relative to the contacted object once it is available on the physics thread
+			const FVector WheelVelocityWorld = UVehicleSystemFunctions::AVS_ChaosGetVelocityAtLocation(PhysicsState.BodyHandle, Trace.ImpactPoint);
+
+			if( WheelMode == EWheelMode::Physics )
 			{
-				const float VehicleMass = PhysicsInput->VehicleMass; // Mass Kg // TODO Input into thread this might crash
-				const float Gravity = -World->GetGravityZ();
-				const float AntiGravityN = (Gravity * VehicleMass) * 0.01f;
-				
-				SpringForceN += AntiGravityN;
-				DamperForceN *= 2;
-			}
+				// Length of spring right now while compressed
+				float Length = Trace.Distance - (Wheels.Radius[WIndex] * 2.0f);
+				float NewSpringLength = FMath::Clamp(Length, 0.0f, SpringLength);
+				WheelOutput.CurrentSpringLength = NewSpringLength; // Used by game thread to place wheel mesh
+
+				// Suspension
+				const FVector WheelVelocityLocal = WheelWorldTransform.Inverse().TransformVectorNoScale(WheelVelocityWorld);
+				const float SpringStrengthNm = Wheels.SpringStrength[WIndex] * 1000.0f; // Spring Strength in N/m
+				const float ShockAbsorption = Wheels.SpringDamping[WIndex] * 1000.0f; // Spring Damper in Ns/m
+				const float CompressionDistanceM = (SpringLength - NewSpringLength) * 0.01f; // Distance of compression in Meters
+				const float CompressionVelocityM = WheelVelocityLocal.Z * (-0.01f); // Velocity of compression in Meters/Second
+
+				float SpringForceN = SpringStrengthNm * CompressionDistanceM;
+				float DamperForceN = ShockAbsorption * CompressionVelocityM;
+
+				// Suspension :: Excess compression
+				if( Length < -1.0f )
+				{
+					SpringForceN += AntiGravityN;
+					DamperForceN *= 2;
+				}
 
-			const float SuspensionForceN = SpringForceN + DamperForceN;
-			FVector SuspensionForceV = (Trace.ImpactNormal * SuspensionForceN) * 100.0f; // Final suspension force in CentiNewtons
+				const float SuspensionForceN = SpringForceN + DamperForceN;
+				FVector SuspensionForceV = (Trace.ImpactNormal * SuspensionForceN) * 100.0f; // Final suspension force in CentiNewtons
 
-			if( WheelConfig.WheelMode == EWheelMode::Physics )
-			{
 				// Apply Suspension Forces
-				UVehicleSystemFunctions::AVS_ChaosAddForceAtLocation(PhysicsInput->VehicleMeshPrim, Trace.Location, SuspensionForceV);
-				UVehicleSystemFunctions::AVS_ChaosAddForce(WheelConfig.WheelPrim, -SuspensionForceV, false);
-				AddDebugForce(PhysicsOutput, FDebugForce(Trace.Location, SuspensionForceV, WheelConfig.WheelMode));
-				PhysicsOutput.WheelOutputs.Add(WheelOutput); // Add the wheel output since we are ending early
+				PhysicsState.Forces.AddForceAtLocation(PhysicsState.BodyHandle, Trace.Location, SuspensionForceV);
+				PhysicsState.Forces.AddForce(WheelHandle, -SuspensionForceV);
+				AddTelemetryForce(PhysicsState, WIndex, Trace.Location, SuspensionForceV, WheelMode);
 
-				if( WheelConfig.IsBrakingWheel )
+				if( EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Braking) )
 				{
 					// Apply Brake Torque
-					float BrakeInput = PhysicsInput->VehicleInputs.Brake; // Set BrakeInput as user input if braking wheel
+					float BrakeInput = VehicleInputs.Brake; // Set BrakeInput as user input if braking wheel
 					//BrakeInput = FMath::Clamp((BrakeInput * BrakePressure), WheelConfig.RollingResistance * 0.1f, 1.0f); // Clamp between Resistance & 1, RollingResistance can just be applied as brakes
-					if( BrakeInput > 0.0f ) UVehicleSystemFunctions::AVS_ChaosBrakes(WheelConfig.WheelPrim, WheelConfig.BrakeTorque * BrakeInput, ChaosDelta); // TODO: Get physics brake torque to properly accept Nm
+					if( BrakeInput > 0.0f ) PhysicsState.Forces.AddBrakes(WheelHandle, BrakeTorque * BrakeInput, ChaosDelta); // TODO: Get physics brake torque to properly accept Nm
 					// TODO Physics rolling resistance
 				}
 				
 				continue; // Finish this wheel here, the physics engine handles friction and torque
 			}
 
-			// Friction
-			const float SurfaceFriction = (Trace.PhysMaterial.IsValid()) ? Trace.PhysMaterial->Friction : 1.0f;
-			FVector2D EffectiveFriction = WheelConfig.TireFriction * SurfaceFriction; // Friction combine method = Multiply
-			
-			// Find current slip angle
-			constexpr float RadToDegree = 180 / PI; // convert radians to degrees
-			const float ASin = FMath::Asin(FVector::DotProduct(RightOnPlane, LinearVelocityOnPlaneNormalized));
-			const float SlipAngle = -ASin * RadToDegree; // Slip angle in degrees
+			const FVector WheelWorldForward = WheelWorldTransform.GetUnitAxis( EAxis::X );
+			const FVector WheelWorldRight = WheelWorldTransform.GetUnitAxis( EAxis::Y );
+			const float SurfaceFriction = PhysicsState.SurfaceFrictions ? PhysicsState.SurfaceFrictions->GetFriction(Trace.PhysMaterial) : 1.0f; // Friction combine method = Multiply
 
-			const float RollingAngVel = WheelVelocityLocal.X / WheelConfig.WheelRadius;
-			WheelState.AngularVelocity = RollingAngVel;
-			
-			// Find SlipX Target
-			float XSlipTarget = 0.0f;
-			if( (PhysicsInput->VehicleInputs.Handbrake && WheelConfig.IsHandbrakeWheel) || WheelConfig.isLocked ) // Wheel Locking
+			float InputTorque = 0.0f;
+			if( (VehicleInputs.Torque > 0.0f) && EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Driving) ) // Throttle
 			{
-				WheelState.AngularVelocity = 0.0f;
-				XSlipTarget = FMath::Sign(-WheelVelocityLocalM.X);
+				InputTorque = VehicleInputs.Torque;
+				if(EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::InvertTorque) ^ VehicleInputs.ReverseTorque) InputTorque *= -1.0f; // Invert torque if needed
 			}
-			else
-			{
-				const float MaxFrictionTorque = SuspensionForceN * (WheelConfig.WheelRadius * 0.01f) * EffectiveFriction.X; // SpringForce(N) * Radius(M) * Friction
+			const bool bLocked = (VehicleInputs.Handbrake && EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Handbrake)) || EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Locked);
 
-				float BrakeInput = WheelConfig.IsBrakingWheel ? PhysicsInput->VehicleInputs.Brake : 0.0f; // Set BrakeInput as user input if braking wheel
-				BrakeInput = FMath::Clamp(BrakeInput, WheelConfig.RollingResistance, 1.0f); // Clamp between Resistance & 1, RollingResistance can just be applied as brakes
-				//float XBrakeTorque = (0.0f - RollingAngVel) / ChaosDelta * WheelConfig.Inertia; XBrakeTorque *= BrakeInput;
-				float XBrakeTorque = FMath::Sign(WheelState.AngularVelocity * (-1.0f)) * WheelConfig.BrakeTorque * BrakeInput;
-
-				float XDriveTorqueNm = 0.0f;
-				if( (PhysicsInput->VehicleInputs.Torque > 0.0f) && WheelConfig.IsDrivingWheel ) // Throttle
+			if( PhysicsInput.SimulationLOD != EVehicleSimulationLOD::LOD0 )
+			{
+				// Simplified tire, traction pulls the contact velocity towards zero up to the friction limit, no slip state
+				const float Length = Trace.Distance - (Wheels.Radius[WIndex] * 2.0f);
+				const float NewSpringLength = FMath::Clamp(Length, 0.0f, SpringLength);
+				const float CompressionDistanceM = (SpringLength - NewSpringLength) * 0.01f; // Distance of compression in Meters
+				const float CompressionVelocityM = FVector::DotProduct(WheelVelocityWorld, WheelWorldUp) * (-0.01f); // Velocity of compression in Meters/Second
+				float SpringForceN = Wheels.SpringStrength[WIndex] * 1000.0f * CompressionDistanceM;
+				if( Length < -1.0f ) SpringForceN += AntiGravityN; // Excess compression
+				const float SuspensionForceN = FMath::Max(SpringForceN + Wheels.SpringDamping[WIndex] * 1000.0f * CompressionVelocityM, 0.0f);
+
+				const FVector ForwardOnPlane = FVector::VectorPlaneProject(WheelWorldForward, Trace.ImpactNormal).GetSafeNormal();
+				const FVector RightOnPlane = FVector::VectorPlaneProject(WheelWorldRight, Trace.ImpactNormal).GetSafeNormal();
+				const float VelocityMX = FVector::DotProduct(WheelVelocityWorld, ForwardOnPlane) * 0.01f; // Meters/Second
+				const float VelocityMY = FVector::DotProduct(WheelVelocityWorld, RightOnPlane) * 0.01f;
+				const float RadiusM = Wheels.RadiusM[WIndex];
+				const float MaxTractionX = Wheels.FrictionX[WIndex] * SurfaceFriction * SuspensionForceN;
+				const float MaxTractionY = Wheels.FrictionY[WIndex] * SurfaceFriction * SuspensionForceN;
+
+				float TractionX;
+				if( bLocked )
 				{
-					float InputTorque = PhysicsInput->VehicleInputs.Torque;
-					if(WheelConfig.InvertTorque ^ PhysicsInput->VehicleInputs.ReverseTorque) InputTorque *= -1.0f; // Invert torque if needed
-					float NewAngVel = WheelState.AngularVelocity + ((InputTorque*100.0f) / WheelConfig.Inertia * ChaosDelta);
-
-					// Calculate the XSlip based on the new angular velocity
-					XDriveTorqueNm = (NewAngVel - RollingAngVel) / ChaosDelta * WheelConfig.Inertia;
+					TractionX = -FMath::Clamp(VelocityMX, -1.0f, 1.0f) * MaxTractionX;
+				}
+				else
+				{
+					const float BrakeAmount = FMath::Clamp(EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Braking) ? VehicleInputs.Brake : 0.0f, Wheels.RollingResistance[WIndex], 1.0f);
+					const float BrakeForceN = BrakeTorque * BrakeAmount / RadiusM * FMath::Clamp(FMath::Abs(VelocityMX), 0.0f, 1.0f); // Fades out near standstill
+					TractionX = FMath::Clamp(InputTorque * FAVS_WheelKernel::DriveTorqueToNm / RadiusM - FMath::Sign(VelocityMX) * BrakeForceN, -MaxTractionX, MaxTractionX); // Same drive scale as LOD0
 				}
+				const float TractionY = -FMath::Clamp(VelocityMY, -1.0f, 1.0f) * MaxTractionY;
 
-				float XFinalTorque = XBrakeTorque + XDriveTorqueNm; // TODO :: Create debug logger and figure out why this doesn't work
-				XSlipTarget = XFinalTorque / MaxFrictionTorque;
+				const FVector FinalWheelForce = (Trace.ImpactNormal * SuspensionForceN + ForwardOnPlane * TractionX + RightOnPlane * TractionY) * 100.0f; // CentiNewtons
+				PhysicsState.Forces.AddForceAtLocation(PhysicsState.BodyHandle, WheelWorldLocation, FinalWheelForce);
+				AddTelemetryForce(PhysicsState, WIndex, WheelWorldLocation, FinalWheelForce, WheelMode);
 
-				/*if( WIndex == 0 )
-				{
-					PhysicsOutput.DebugTexts.Add(DEBUG("Physics Thread: XBrakeTorque: %f", XBrakeTorque));
-					PhysicsOutput.DebugTexts.Add(DEBUG("Physics Thread: XDriveTorqueNm: %f", XDriveTorqueNm));
-					PhysicsOutput.DebugTexts.Add(DEBUG("Physics Thread: XFinalTorque: %f", XFinalTorque));
-					PhysicsOutput.DebugTexts.Add(DEBUG("Physics Thread: XSlipTarget: %f", XSlipTarget));
-				}*/
+				WheelState.Slip = FVector2D::ZeroVector;
+				WheelState.AngularVelocity = bLocked ? 0.0f : VelocityMX / RadiusM;
+				WheelOutput.CurrentSpringLength = NewSpringLength; // Used by game thread to place wheel mesh
+				WheelOutput.AngularVelocity = WheelState.AngularVelocity;
+				continue;
 			}
 
-			// Interpolate SlipX to target
-			float SlipX = WheelState.Slip.X; // Long Slip
-			const float InterpSpeedLong = FMath::Clamp(FMath::Abs(WheelVelocityLocalM.X) / 0.010f * ChaosDelta, 0.0f, 1.0f);
-			SlipX += (XSlipTarget - SlipX) * InterpSpeedLong;
-			SlipX = FMath::Clamp(SlipX, -30.0f, 30.0f); // Long Slip Limit
-			
-			// Find SlipY Target :: Simply Lerp from LowSpeedSlip -> HighSpeedSlip
-			const float YSlipTargetHighSpeed = SlipAngle / 12.0f; // SlipAngle / SlipAnglePeak
-			const float YSlipTargetLowSpeed = -FMath::Sign(WheelVelocityLocalM.Y);
-			const float Alpha = FMath::GetMappedRangeValueClamped(FVector2D(1.0f, 2.0f), FVector2D(0.0f, 1.0f), WheelVelocity);
-			const float YSlipTarget = FMath::Lerp(YSlipTargetLowSpeed, YSlipTargetHighSpeed, Alpha);
-			
-			// Interpolate SlipY to target
-			float SlipY = WheelState.Slip.Y; // Lat Slip
-            const float InterpSpeedLat = FMath::Clamp(FMath::Abs(WheelVelocityLocalM.Y) / 0.007f * ChaosDelta, 0.0f, 1.0f);
-            SlipY += (YSlipTarget - SlipY) * InterpSpeedLat;
-			
-			// Create final slip data
-            FVector2D Slip = FVector2D(SlipX, SlipY);
-			WheelState.Slip = Slip; // Save actual slip data before normalizing for final force
-			const float SlipLength = Slip.Size();
-            if (SlipLength > 1.0f) // Normalize
-            {
-                Slip.X /= SlipLength;
-                Slip.Y /= SlipLength;
-            }
-            Slip.Y = FMath::Sign(Slip.Y) * FMath::Sqrt(FMath::Abs(Slip.Y) ); // Square root the Lateral Force
-			
-			// Traction, the normalized slip defines how much we are using in each direction
-            const FVector TractionForward = ForwardOnPlane * Slip.X * EffectiveFriction.X;
-            const FVector TractionRight = RightOnPlane * Slip.Y * EffectiveFriction.Y;
-            FVector FrictionForceV = ((TractionForward + TractionRight) * SuspensionForceN)*100.0f; // *100.0f to convert to CentiNewtons
-
-			// Apply Forces
-			FVector FinalWheelForce = SuspensionForceV + FrictionForceV;
-			UVehicleSystemFunctions::AVS_ChaosAddForceAtLocation(PhysicsInput->VehicleMeshPrim, WheelWorldLocation, FinalWheelForce);
-			AddDebugForce(PhysicsOutput, FDebugForce(WheelWorldLocation, FinalWheelForce, WheelConfig.WheelMode));
+			// Raycast wheel, suspension and friction are solved with every other vehicle in the wheel kernel
+			const int32 Lane = WheelKernel.AddLane(WIndex);
+
+			WheelKernel.Get(FAVS_WheelKernel::NormalX, Lane) = Trace.ImpactNormal.X;
+			WheelKernel.Get(FAVS_WheelKernel::NormalY, Lane) = Trace.ImpactNormal.Y;
+			WheelKernel.Get(FAVS_WheelKernel::NormalZ, Lane) = Trace.ImpactNormal.Z;
+			WheelKernel.Get(FAVS_WheelKernel::ForwardX, Lane) = WheelWorldForward.X;
+			WheelKernel.Get(FAVS_WheelKernel::ForwardY, Lane) = WheelWorldForward.Y;
+			WheelKernel.Get(FAVS_WheelKernel::ForwardZ, Lane) = WheelWorldForward.Z;
+			WheelKernel.Get(FAVS_WheelKernel::RightX, Lane) = WheelWorldRight.X;
+			WheelKernel.Get(FAVS_WheelKernel::RightY, Lane) = WheelWorldRight.Y;
+			WheelKernel.Get(FAVS_WheelKernel::RightZ, Lane) = WheelWorldRight.Z;
+			WheelKernel.Get(FAVS_WheelKernel::UpX, Lane) = WheelWorldUp.X;
+			WheelKernel.Get(FAVS_WheelKernel::UpY, Lane) = WheelWorldUp.Y;
+			WheelKernel.Get(FAVS_WheelKernel::UpZ, Lane) = WheelWorldUp.Z;
+			WheelKernel.Get(FAVS_WheelKernel::VelocityX, Lane) = WheelVelocityWorld.X;
+			WheelKernel.Get(FAVS_WheelKernel::VelocityY, Lane) = WheelVelocityWorld.Y;
+			WheelKernel.Get(FAVS_WheelKernel::VelocityZ, Lane) = WheelVelocityWorld.Z;
+			WheelKernel.Get(FAVS_WheelKernel::TraceDistance, Lane) = Trace.Distance;
+			WheelKernel.Get(FAVS_WheelKernel::Radius, Lane) = Wheels.Radius[WIndex];
+			WheelKernel.Get(FAVS_WheelKernel::RadiusM, Lane) = Wheels.RadiusM[WIndex];
+			WheelKernel.Get(FAVS_WheelKernel::SpringLength, Lane) = SpringLength;
+			WheelKernel.Get(FAVS_WheelKernel::SpringStrength, Lane) = Wheels.SpringStrength[WIndex];
+			WheelKernel.Get(FAVS_WheelKernel::SpringDamping, Lane) = Wheels.SpringDamping[WIndex];
+			WheelKernel.Get(FAVS_WheelKernel::Inertia, Lane) = Wheels.Inertia[WIndex];
+			WheelKernel.Get(FAVS_WheelKernel::FrictionX, Lane) = Wheels.FrictionX[WIndex] * SurfaceFriction;
+			WheelKernel.Get(FAVS_WheelKernel::FrictionY, Lane) = Wheels.FrictionY[WIndex] * SurfaceFriction;
+			WheelKernel.Get(FAVS_WheelKernel::BrakeTorque, Lane) = BrakeTorque;
+			WheelKernel.Get(FAVS_WheelKernel::RollingResistance, Lane) = Wheels.RollingResistance[WIndex];
+			WheelKernel.Get(FAVS_WheelKernel::BrakeInput, Lane) = EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Braking) ? VehicleInputs.Brake : 0.0f;
+			WheelKernel.Get(FAVS_WheelKernel::DriveTorque, Lane) = InputTorque;
+			WheelKernel.Get(FAVS_WheelKernel::Locked, Lane) = bLocked ? 1.0f : 0.0f;
+			WheelKernel.Get(FAVS_WheelKernel::AntiGravity, Lane) = AntiGravityN;
+			WheelKernel.Get(FAVS_WheelKernel::SlipX, Lane) = WheelState.Slip.X;
+			WheelKernel.Get(FAVS_WheelKernel::SlipY, Lane) = WheelState.Slip.Y;
+			continue;
 		}
 		else // TraceHit
 		{
-			WheelOutput.CurrentSpringLength = WheelConfig.SpringLength; // Used by game thread to place wheel mesh
+			WheelOutput.CurrentSpringLength = SpringLength; // Used by game thread to place wheel mesh
 			WheelState.Slip = FVector2D::ZeroVector; // No slip while in air
 
-			if( (PhysicsInput->VehicleInputs.Handbrake && WheelConfig.IsHandbrakeWheel) // Handbrake
-				|| ((PhysicsInput->VehicleInputs.Brake > 0.0f) && WheelConfig.IsBrakingWheel) ) // Normal brake
+			if( (VehicleInputs.Handbrake && EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Handbrake)) // Handbrake
+				|| ((VehicleInputs.Brake > 0.0f) && EnumHasAnyFlags(WheelFlags, EAVS_WheelFlags::Braking)) ) // Normal brake
 			{
 				WheelState.AngularVelocity = 0.0f;
 			}
 
-			if( WheelConfig.WheelMode == EWheelMode::Physics )
+			if( WheelMode == EWheelMode::Physics )
 			{
-				FTransform PhysWheelTransform = UVehicleSystemFunctions::AVS_GetChaosTransform(WheelConfig.WheelPrim);
-				FVector SpringStart = WheelWorldLocation + WheelWorldUp * (WheelConfig.SpringLength * 0.5f);
+				FTransform PhysWheelTransform = UVehicleSystemFunctions::AVS_GetChaosTransform(WheelHandle);
+				FVector SpringStart = WheelWorldLocation + WheelWorldUp * (SpringLength * 0.5f);
 
 				float NewSpringLength = FVector::Dist(SpringStart, PhysWheelTransform.GetLocation());
-				NewSpringLength = FMath::Clamp(NewSpringLength, 0.0f, WheelConfig.SpringLength);
+				NewSpringLength = FMath::Clamp(NewSpringLength, 0.0f, SpringLength);
 
-				if( NewSpringLength < WheelConfig.SpringLength )
+				if( NewSpringLength < SpringLength )
 				{
-					const float SpringStrengthNm = WheelConfig.SpringStrength * 1000.0f; // Spring Strength in N/m
-					const float CompressionDistanceM = (WheelConfig.SpringLength - NewSpringLength) * 0.01f; // Distance of compression in Meters
+					const float SpringStrengthNm = Wheels.SpringStrength[WIndex] * 1000.0f; // Spring Strength in N/m
+					const float CompressionDistanceM = (SpringLength - NewSpringLength) * 0.01f; // Distance of compression in Meters
 					float SpringForceN = SpringStrengthNm * CompressionDistanceM;
 					const float SuspensionForceN = SpringForceN;
 					FVector SuspensionForceV = (WheelWorldUp * SuspensionForceN) * 100.0f; // Final suspension force in CentiNewtons
 
 					// Apply Suspension Forces
-					UVehicleSystemFunctions::AVS_ChaosAddForceAtLocation(PhysicsInput->VehicleMeshPrim, PhysWheelTransform.GetLocation(), SuspensionForceV);
-					UVehicleSystemFunctions::AVS_ChaosAddForce(WheelConfig.WheelPrim, -SuspensionForceV, false);
-					AddDebugForce(PhysicsOutput, FDebugForce(PhysWheelTransform.GetLocation(), SuspensionForceV, WheelConfig.WheelMode));
+					PhysicsState.Forces.AddForceAtLocation(PhysicsState.BodyHandle, PhysWheelTransform.GetLocation(), SuspensionForceV);
+					PhysicsState.Forces.AddForce(WheelHandle, -SuspensionForceV);
+					AddTelemetryForce(PhysicsState, WIndex, PhysWheelTransform.GetLocation(), SuspensionForceV, WheelMode);
 				}
 			}
 		}
 		WheelOutput.AngularVelocity = WheelState.AngularVelocity;
-		PhysicsOutput.WheelOutputs.Add(WheelOutput);
 	}
+
+	PhysicsState.NumKernelLanes = WheelKernel.NumLanes - PhysicsState.FirstKernelLane;
+}
+
+void AVehicleSystemBase::AVS_ApplyWheelKernel(const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState, const FAVS_WheelKernel& WheelKernel,
+	FVehiclePhysicsVehicleOutput& PhysicsOutput)
+{
+	for( int32 Lane = PhysicsState.FirstKernelLane; Lane < PhysicsState.FirstKernelLane + PhysicsState.NumKernelLanes; ++Lane )
+	{
+		const int32 WIndex = WheelKernel.WheelIndex[Lane];
+		FAVS1_Wheel_Output& WheelOutput = PhysicsOutput.WheelOutputs[WIndex];
+		FAVS1_Wheel_State& WheelState = PhysicsState.WheelStates[WIndex];
+
+		WheelState.Slip = FVector2D(WheelKernel.Get(FAVS_WheelKernel::SlipX, Lane), WheelKernel.Get(FAVS_WheelKernel::SlipY, Lane)); // Actual slip, not normalized
+		WheelState.AngularVelocity = WheelKernel.Get(FAVS_WheelKernel::AngularVelocity, Lane);
+		WheelOutput.CurrentSpringLength = WheelKernel.Get(FAVS_WheelKernel::CurrentSpringLength, Lane); // Used by game thread to place wheel mesh
+		WheelOutput.AngularVelocity = WheelState.AngularVelocity;
+
+		// Apply Forces
+		const FVector WheelWorldLocation = PhysicsState.WheelWorldTransforms[WIndex].GetLocation();
+		const FVector FinalWheelForce(WheelKernel.Get(FAVS_WheelKernel::ForceX, Lane), WheelKernel.Get(FAVS_WheelKernel::ForceY, Lane), WheelKernel.Get(FAVS_WheelKernel::ForceZ, Lane));
+		PhysicsState.Forces.AddForceAtLocation(PhysicsState.BodyHandle, WheelWorldLocation, FinalWheelForce);
+		AddTelemetryForce(PhysicsState, WIndex, WheelWorldLocation, FinalWheelForce, EWheelMode::Raycast);
+	}
+}
+
+void AVehicleSystemBase::AVS_StepVehicle(float ChaosDelta, const UWorld* World, const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState,
+	FAVS_WheelQueryBatch& WheelQueries, FAVS_WheelKernel& WheelKernel, FVehiclePhysicsVehicleOutput& PhysicsOutput)
+{
+	WheelQueries.Reset();
+	WheelKernel.Reset();
+	PhysicsOutput.Reset();
+
+	AVS_GatherWheelQueries(PhysicsInput, PhysicsState, WheelQueries);
+	WheelQueries.Resolve(World);
+	AVS_PhysicsTick(ChaosDelta, World, PhysicsInput, PhysicsState, WheelQueries, WheelKernel, PhysicsOutput);
+	WheelKernel.Solve(ChaosDelta);
+	AVS_ApplyWheelKernel(PhysicsInput, PhysicsState, WheelKernel, PhysicsOutput);
 }
 
 bool AVehicleSystemBase::SetArrayDisabledCollisions(TArray<UPrimitiveComponent*> Meshes)
@@ -898,7 +1913,7 @@ bool AVehicleSystemBase::SetArrayDisabledCollisions(TArray<UPrimitiveComponent*>
 			}
 		}
 		ContactModMeshes = Meshes; // Save the new array
-		PhysicsThreadCallback->WheelMeshes = ChaosHandles; // Overwrite array, not add, we don't want invalid handles
+		ContactModProxies = ChaosHandles; // Overwrite array, not add, we don't want invalid handles
 		return true; // Success
 	}
 	return false; // Callback is not valid, failed
@@ -162,70 +162,89 @@ double UVehicleSystemFunctions::LinearSpeedToRads(double cm_per_sec, float Radiu
 
 //Chaos physics thread force functions
 
-FTransform UVehicleSystemFunctions::AVS_GetChaosTransform(UPrimitiveComponent* target)
+Chaos::FRigidBodyHandle_Internal* UVehicleSystemFunctions::GetRigidHandle(const UPrimitiveComponent* target)
 {
-	if(IsValid(target))
+	if(!IsValid(target))
+		return nullptr;
+
+	if(const FBodyInstance* BodyInstance = target->GetBodyInstance())
 	{
-		if(const FBodyInstance* BodyInstance = target->GetBodyInstance())
+		if(auto Handle = BodyInstance->ActorHandle)
 		{
-			if(auto Handle = BodyInstance->ActorHandle)
-			{
-				if(Chaos::FRigidBodyHandle_Internal* RigidHandle = Handle->GetPhysicsThreadAPI())
-				{
-					const Chaos::FRigidTransform3 WorldCOM = Chaos::FParticleUtilitiesGT::GetActorWorldTransform(RigidHandle);
-					return WorldCOM;
-				}
-			}
+			return Handle->GetPhysicsThreadAPI();
 		}
 	}
-	return FTransform();
+	return nullptr;
+}
+
+FTransform UVehicleSystemFunctions::AVS_GetChaosTransform(UPrimitiveComponent* target)
+{
+	return AVS_GetChaosTransform(GetRigidHandle(target));
+}
+
+FTransform UVehicleSystemFunctions::AVS_GetChaosTransform(const Chaos::FRigidBodyHandle_Internal* RigidHandle)
+{
+	if(RigidHandle == nullptr)
+		return FTransform();
+
+	const Chaos::FRigidTransform3 WorldCOM = Chaos::FParticleUtilitiesGT::GetActorWorldTransform(RigidHandle);
+	return WorldCOM;
 }
 
 
 void UVehicleSystemFunctions::AVS_ChaosAddForce(UPrimitiveComponent* target, FVector Force, bool bAccelChange = false)
 {
-	if(!target)
+	AVS_ChaosAddForce(GetRigidHandle(target), Force, bAccelChange);
+}
+
+void UVehicleSystemFunctions::AVS_ChaosAddForce(Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Force, bool bAccelChange)
+{
+	if(RigidHandle == nullptr)
 		return;
-	
-	if(const FBodyInstance* BodyInstance = target->GetBodyInstance())
+
+	if(bAccelChange)
 	{
-		if(auto Handle = BodyInstance->ActorHandle)
-		{
-			if(Chaos::FRigidBodyHandle_Internal* RigidHandle = Handle->GetPhysicsThreadAPI())
-			{
-				if(bAccelChange)
-				{
-					const float RigidMass = RigidHandle->M();
-					const Chaos::FVec3 Acceleration = Force * RigidMass;
-					RigidHandle->AddForce(Acceleration, false);
-				}
-				else
-				{
-					RigidHandle->AddForce(Force, false);
-				}
-			}
-		}
+		const float RigidMass = RigidHandle->M();
+		const Chaos::FVec3 Acceleration = Force * RigidMass;
+		RigidHandle->AddForce(Acceleration, false);
+	}
+	else
+	{
+		RigidHandle->AddForce(Force, false);
 	}
 }
 
 void UVehicleSystemFunctions::AVS_ChaosAddForceAtLocation(UPrimitiveComponent* target, FVector Location, FVector Force)
 {
-	if(!target)
+	AVS_ChaosAddForceAtLocation(GetRigidHandle(target), Location, Force);
+}
+
+void UVehicleSystemFunctions::AVS_ChaosAddForceAtLocation(Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Location, FVector Force)
+{
+	if(RigidHandle == nullptr)
 		return;
-	
-	if(const FBodyInstance* BodyInstance = target->GetBodyInstance())
-	{
-		if(auto Handle = BodyInstance->ActorHandle)
-		{
-			if(Chaos::FRigidBodyHandle_Internal* RigidHandle = Handle->GetPhysicsThreadAPI())
-			{
-				const Chaos::FVec3 WorldCOM = Chaos::FParticleUtilitiesGT::GetCoMWorldPosition(RigidHandle);
-				const Chaos::FVec3 WorldTorque = Chaos::FVec3::CrossProduct(Location - WorldCOM, Force);
-				RigidHandle->AddForce(Force, false);
-				RigidHandle->AddTorque(WorldTorque, false);
-			}
-		}
-	}
+
+	const Chaos::FVec3 WorldCOM = Chaos::FParticleUtilitiesGT::GetCoMWorldPosition(RigidHandle);
+	const Chaos::FVec3 WorldTorque = Chaos::FVec3::CrossProduct(Location - WorldCOM, Force);
+	RigidHandle->AddForce(Force, false);
+	RigidHandle->AddTorque(WorldTorque, false);
+}
+
+FVector UVehicleSystemFunctions::AVS_ChaosGetCenterOfMass(const Chaos::FRigidBodyHandle_Internal* RigidHandle)
+{
+	if(RigidHandle == nullptr)
+		return FVector::ZeroVector;
+
+	return Chaos::FParticleUtilitiesGT::GetCoMWorldPosition(RigidHandle);
+}
+
+void UVehicleSystemFunctions::AVS_ChaosAddAccumulatedForce(Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Force, FVector Torque)
+{
+	if(RigidHandle == nullptr)
+		return;
+
+	RigidHandle->AddForce(Force, false);
+	RigidHandle->AddTorque(Torque, false);
 }
 
 void UVehicleSystemFunctions::AVS_ChaosAddTorque(UPrimitiveComponent* target, FVector Torque, bool bAccelChange)
@@ -308,48 +327,39 @@ void UVehicleSystemFunctions::AVS_SetWheelAngularVelocity(UPrimitiveComponent* t
 
 void UVehicleSystemFunctions::AVS_ChaosBrakes(UPrimitiveComponent* target, float BrakeTorque, float ChaosDelta)
 {
-	if(!target)
+	AVS_ChaosBrakes(GetRigidHandle(target), BrakeTorque, ChaosDelta);
+}
+
+void UVehicleSystemFunctions::AVS_ChaosBrakes(Chaos::FRigidBodyHandle_Internal* RigidHandle, float BrakeTorque, float ChaosDelta)
+{
+	if(RigidHandle == nullptr)
 		return;
-	
-	if(const FBodyInstance* BodyInstance = target->GetBodyInstance())
-	{
-		if(auto Handle = BodyInstance->ActorHandle)
-		{
-			if(Chaos::FRigidBodyHandle_Internal* RigidHandle = Handle->GetPhysicsThreadAPI())
-			{
-				FTransform TargetWorldTransform(RigidHandle->R(), RigidHandle->X());
 
-				Chaos::FVec3 AngVel = RigidHandle->W();
-				Chaos::FVec3 FullStopTorque = (AngVel / ChaosDelta)*(-1.0f);
+	FTransform TargetWorldTransform(RigidHandle->R(), RigidHandle->X());
 
-				Chaos::FVec3 FullStopTorqueLocal = TargetWorldTransform.InverseTransformVectorNoScale(FullStopTorque); // Convert to local space
-				FullStopTorqueLocal *= Chaos::FVec3::RightVector; // Isolate the Y rotation
+	Chaos::FVec3 AngVel = RigidHandle->W();
+	Chaos::FVec3 FullStopTorque = (AngVel / ChaosDelta)*(-1.0f);
 
-				Chaos::FVec3 FullStopTorqueY = RigidHandle->R().RotateVector(FullStopTorqueLocal); // Convert back to world space
-				Chaos::FVec3 FinalBrakeForce = FullStopTorqueY.GetClampedToMaxSize(BrakeTorque); // Clamp to input brake force, if full stop exceeds brake force, wheel will only be slowed
-				RigidHandle->AddTorque(Chaos::FParticleUtilitiesXR::GetWorldInertia(RigidHandle) * FinalBrakeForce, false);
-			}
-		}
-	}
+	Chaos::FVec3 FullStopTorqueLocal = TargetWorldTransform.InverseTransformVectorNoScale(FullStopTorque); // Convert to local space
+	FullStopTorqueLocal *= Chaos::FVec3::RightVector; // Isolate the Y rotation
+
+	Chaos::FVec3 FullStopTorqueY = RigidHandle->R().RotateVector(FullStopTorqueLocal); // Convert back to world space
+	Chaos::FVec3 FinalBrakeForce = FullStopTorqueY.GetClampedToMaxSize(BrakeTorque); // Clamp to input brake force, if full stop exceeds brake force, wheel will only be slowed
+	RigidHandle->AddTorque(Chaos::FParticleUtilitiesXR::GetWorldInertia(RigidHandle) * FinalBrakeForce, false);
 }
 
 FVector UVehicleSystemFunctions::AVS_ChaosGetVelocityAtLocation(UPrimitiveComponent* target, FVector Location)
 {
-	if(const FBodyInstance* BodyInstance = target->GetBodyInstance())
-	{
-		if(!BodyInstance)
-			return FVector::ZeroVector;
+	return AVS_ChaosGetVelocityAtLocation(GetRigidHandle(target), Location);
+}
 
-		if(auto Handle = BodyInstance->ActorHandle)
-		{
-			if(Chaos::FRigidBodyHandle_Internal* RigidHandle = Handle->GetPhysicsThreadAPI())
-			{
-				const bool bIsRigid = RigidHandle->CanTreatAsRigid();
-				const Chaos::FVec3 COM = bIsRigid ? Chaos::FParticleUtilitiesGT::GetCoMWorldPosition(RigidHandle) : static_cast<Chaos::FVec3>(Chaos::FParticleUtilitiesGT::GetActorWorldTransform(RigidHandle).GetTranslation());
-				const Chaos::FVec3 Diff = Location - COM;
-				return RigidHandle->V() - Chaos::FVec3::CrossProduct(Diff, RigidHandle->W());
-			}
-		}
-	}
-	return FVector::ZeroVector;
+FVector UVehicleSystemFunctions::AVS_ChaosGetVelocityAtLocation(const Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Location)
+{
+	if(RigidHandle == nullptr)
+		return FVector::ZeroVector;
+
+	const bool bIsRigid = RigidHandle->CanTreatAsRigid();
+	const Chaos::FVec3 COM = bIsRigid ? Chaos::FParticleUtilitiesGT::GetCoMWorldPosition(RigidHandle) : static_cast<Chaos::FVec3>(Chaos::FParticleUtilitiesGT::GetActorWorldTransform(RigidHandle).GetTranslation());
+	const Chaos::FVec3 Diff = Location - COM;
+	return RigidHandle->V() - Chaos::FVec3::CrossProduct(Diff, RigidHandle->W());
 }
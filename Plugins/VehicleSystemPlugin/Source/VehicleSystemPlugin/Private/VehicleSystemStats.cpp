@@ -0,0 +1,36 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleSystemStats.h"
+
+DEFINE_STAT(STAT_AVS_PreSimulate);
+DEFINE_STAT(STAT_AVS_WheelTraces);
+DEFINE_STAT(STAT_AVS_PhysicsTick);
+DEFINE_STAT(STAT_AVS_ApplyForces);
+DEFINE_STAT(STAT_AVS_ContactModification);
+DEFINE_STAT(STAT_AVS_Replay);
+DEFINE_STAT(STAT_AVS_AlwaysTick);
+DEFINE_STAT(STAT_AVS_SyncPhysics);
+DEFINE_STAT(STAT_AVS_NetStateSend);
+DEFINE_STAT(STAT_AVS_WheelVisuals);
+DEFINE_STAT(STAT_AVS_Subsystem);
+
+DEFINE_STAT(STAT_AVS_VehiclesSimulated);
+DEFINE_STAT(STAT_AVS_WheelsSimulated);
+DEFINE_STAT(STAT_AVS_Traces);
+DEFINE_STAT(STAT_AVS_ForcesApplied);
+DEFINE_STAT(STAT_AVS_QueueDepth);
+DEFINE_STAT(STAT_AVS_BytesSent);
+
+CSV_DEFINE_CATEGORY_MODULE(VEHICLESYSTEMPLUGIN_API, AVS, false);
+UE_TRACE_CHANNEL_DEFINE(AVSChannel);
+
+static TAutoConsoleVariable<bool> CVarAVSStats(
+	TEXT("avs.Stats"),
+	false,
+	TEXT("Records the vehicle counters (vehicles, wheels, traces, forces, net queue depth, bytes sent) in stat AVS and the AVS CSV category"));
+
+bool AVSStats::IsEnabled()
+{
+	return CVarAVSStats.GetValueOnAnyThread();
+}
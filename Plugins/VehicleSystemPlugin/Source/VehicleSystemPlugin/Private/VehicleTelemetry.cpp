@@ -0,0 +1,52 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleTelemetry.h"
+
+void FAVS_TelemetryRing::Initialize(int32 InCapacity)
+{
+	const int32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(InCapacity, 2));
+	Records.SetNum(Capacity);
+	Mask = Capacity - 1;
+	Head.store(0, std::memory_order_relaxed);
+	Tail = 0;
+}
+
+void FAVS_TelemetryRing::Push(const FAVS_TelemetryRecord& Record)
+{
+	const uint64 Index = Head.load(std::memory_order_relaxed);
+	Records[Index & Mask] = Record;
+	Head.store(Index + 1, std::memory_order_release);
+}
+
+int32 FAVS_TelemetryRing::Drain(TArray<FAVS_TelemetryRecord>& OutRecords)
+{
+	const uint64 Capacity = Mask + 1;
+	const uint64 End = Head.load(std::memory_order_acquire);
+
+	// Records older than one capacity were already overwritten
+	uint64 Dropped = 0;
+	if( End - Tail > Capacity )
+	{
+		Dropped = End - Capacity - Tail;
+		Tail = End - Capacity;
+	}
+
+	const uint64 Start = Tail;
+	const int32 FirstRecord = OutRecords.Num();
+	for( ; Tail < End; ++Tail )
+	{
+		OutRecords.Add(Records[Tail & Mask]);
+	}
+
+	// The producer kept writing while we copied, the slots it reached may hold torn records
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64 Written = Head.load(std::memory_order_relaxed);
+	if( Written + 1 > Start + Capacity )
+	{
+		const uint64 Torn = FMath::Min<uint64>(Written + 1 - Capacity - Start, End - Start);
+		OutRecords.RemoveAt(FirstRecord, static_cast<int32>(Torn), EAllowShrinking::No);
+		Dropped += Torn;
+	}
+	return static_cast<int32>(Dropped);
+}
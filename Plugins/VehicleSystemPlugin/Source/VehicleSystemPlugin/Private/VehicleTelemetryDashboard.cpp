@@ -0,0 +1,267 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleTelemetryDashboard.h"
+
+#include "VehicleSimulationSubsystem.h"
+#include "VehicleSystemBase.h"
+
+#if WITH_AVS_IMGUI
+#include "RMAImGui.h"
+#include "RMAImGuiHook.h"
+#define AVS_IMGUI (RMAIMGUI_LIBRARY)
+#else
+#define AVS_IMGUI 0
+#endif
+
+static TAutoConsoleVariable<float> CVarAVSDashboardHistory(
+	TEXT("avs.Debug.DashboardHistory"),
+	120.0f,
+	TEXT("Seconds of history kept by the telemetry dashboard at 60 samples per second, read when a vehicle is selected"));
+
+static const FName DashboardContextName(TEXT("AVS_Telemetry"));
+
+FAVS_TelemetryDashboard::FAVS_TelemetryDashboard(UVehicleSimulationSubsystem* InSimulation)
+	: Simulation(InSimulation)
+{
+	#if AVS_IMGUI
+	if( !FRMAImGui::IsAvailable() ) { bOpen = false; return; }
+
+	TWeakPtr<SOverlay> Slot = RMAImGui::Slots::GetSlot();
+	if( !Slot.IsValid() ) { bOpen = false; return; }
+
+	TWeakPtr<SRMAImGuiContext> Context = FRMAImGui::Get().CreateContext(DashboardContextName, Slot.Pin().ToSharedRef());
+	if( !Context.IsValid() ) { bOpen = false; return; }
+
+	Hook = new FRMAImGuiHook([this](TWeakPtr<SRMAImGuiContext>) { Draw(); });
+	Context.Pin()->AddHook(Hook);
+	InSimulation->AddTelemetryViewer();
+	#else
+	bOpen = false; // No ImGui on this platform
+	#endif
+}
+
+FAVS_TelemetryDashboard::~FAVS_TelemetryDashboard()
+{
+	#if AVS_IMGUI
+	if( Hook != nullptr )
+	{
+		if( FRMAImGui::IsAvailable() && !FRMAImGui::Get().IsShuttingDown() )
+		{
+			TWeakPtr<SRMAImGuiContext> Context = FRMAImGui::Get().FindContext(DashboardContextName);
+			if( Context.IsValid() ) Context.Pin()->RemoveHook(Hook);
+			FRMAImGui::Get().ReleaseContext(DashboardContextName);
+		}
+		delete Hook;
+		if( UVehicleSimulationSubsystem* VehicleSimulation = Simulation.Get() ) VehicleSimulation->RemoveTelemetryViewer();
+	}
+	#endif
+}
+
+void FAVS_TelemetryDashboard::SelectVehicle(int32 InVehicleId, int32 InNumWheels)
+{
+	UVehicleSimulationSubsystem* VehicleSimulation = Simulation.Get();
+	VehicleId = InVehicleId;
+	VehicleSerial = VehicleSimulation ? VehicleSimulation->GetVehicleSerial(InVehicleId) : 0;
+	NumWheels = InNumWheels;
+
+	// Allocated once per selection, sampling never allocates
+	Capacity = FMath::Max(FMath::CeilToInt32(CVarAVSDashboardHistory.GetValueOnGameThread() * 60.0f), 60);
+	NumSamples = 0;
+	NextSample = 0;
+	Times.SetNumZeroed(Capacity);
+	Values.SetNumZeroed(Capacity * GetNumChannels());
+}
+
+void FAVS_TelemetryDashboard::Sample(float DeltaTime)
+{
+	UVehicleSimulationSubsystem* VehicleSimulation = Simulation.Get();
+	if( !bOpen || VehicleSimulation == nullptr ) return;
+	Time += DeltaTime;
+
+	// Keep following the selected vehicle, fall back to the first one that is still registered
+	AVehicleSystemBase* Vehicle = VehicleSimulation->GetVehicle(VehicleId);
+	if( Vehicle == nullptr || VehicleSimulation->GetVehicleSerial(VehicleId) != VehicleSerial )
+	{
+		VehicleId = INDEX_NONE;
+		for( int32 Id = 0; Id < VehicleSimulation->GetNumVehicleIds() && Vehicle == nullptr; ++Id )
+		{
+			Vehicle = VehicleSimulation->GetVehicle(Id);
+			if( Vehicle ) SelectVehicle(Id, 0);
+		}
+		if( Vehicle == nullptr ) return;
+	}
+
+	// Only the latest substep is sampled, one sample per frame
+	const TArrayView<const FAVS_TelemetryRecord> Records = VehicleSimulation->GetVehicleTelemetry(VehicleId);
+	const uint32 LatestSubstep = Records.Num() > 0 ? Records.Last().Substep : 0;
+	int32 RecordedWheels = 0;
+	for( const FAVS_TelemetryRecord& Record : Records )
+	{
+		if( Record.Substep == LatestSubstep && Record.Type == EAVS_TelemetryType::Wheel ) RecordedWheels = FMath::Max(RecordedWheels, Record.WheelIndex + 1);
+	}
+	if( RecordedWheels > NumWheels ) SelectVehicle(VehicleId, RecordedWheels); // Wheel count only grows, the history restarts
+
+	const int32 Index = NextSample;
+	NextSample = (NextSample + 1) % Capacity;
+	NumSamples = FMath::Min(NumSamples + 1, Capacity);
+	Times[Index] = Time;
+
+	const FAVS_JitterBufferStats JitterStats = Vehicle->GetJitterBufferStats();
+	GetChannel(ChaosDeltaTime)[Index] = VehicleSimulation->GetChaosDeltaTime() * 1000.0f;
+	GetChannel(QueueDepth)[Index] = JitterStats.Depth;
+	GetChannel(NetError)[Index] = JitterStats.NetError;
+
+	// Wheels without a record this frame (dormant vehicle, no new output) keep their last value
+	const int32 LastIndex = (Index + Capacity - 1) % Capacity;
+	for( int32 Channel = NumVehicleChannels; Channel < GetNumChannels(); ++Channel )
+	{
+		GetChannel(Channel)[Index] = NumSamples > 1 ? GetChannel(Channel)[LastIndex] : 0.0f;
+	}
+	for( int32 Channel = NumVehicleChannels + Force; Channel < GetNumChannels(); Channel += NumWheelChannels )
+	{
+		GetChannel(Channel)[Index] = 0.0f; // Forces are summed below
+	}
+
+	for( const FAVS_TelemetryRecord& Record : Records )
+	{
+		if( Record.Substep != LatestSubstep || !FMath::IsWithin<int32>(Record.WheelIndex, 0, NumWheels) ) continue;
+
+		const int32 WheelChannel = NumVehicleChannels + Record.WheelIndex * NumWheelChannels;
+		if( Record.Type == EAVS_TelemetryType::Wheel )
+		{
+			GetChannel(WheelChannel + SlipX)[Index] = Record.Slip.X;
+			GetChannel(WheelChannel + SlipY)[Index] = Record.Slip.Y;
+			GetChannel(WheelChannel + SpringLength)[Index] = Record.SpringLength;
+			GetChannel(WheelChannel + AngularVelocity)[Index] = Record.AngularVelocity;
+		}
+		else if( Record.Type == EAVS_TelemetryType::Force )
+		{
+			GetChannel(WheelChannel + Force)[Index] += Record.End.Size() * 0.01f; // cN to N
+		}
+	}
+}
+
+#if AVS_IMGUI
+
+namespace
+{
+	// Plots a window of one channel straight out of the history ring
+	struct FPlotSource
+	{
+		const float* Times;
+		const float* Values;
+		int32 FirstSample;
+		int32 Capacity;
+	};
+
+	ImPlotPoint GetPlotPoint(int Index, void* Data)
+	{
+		const FPlotSource& Source = *static_cast<const FPlotSource*>(Data);
+		const int32 Sample = (Source.FirstSample + Index) % Source.Capacity;
+		return ImPlotPoint(Source.Times[Sample], Source.Values[Sample]);
+	}
+}
+
+void FAVS_TelemetryDashboard::DrawChannel(const char* Label, int32 Channel, int32 FirstSample, int32 Count)
+{
+	FPlotSource Source { Times.GetData(), GetChannel(Channel), FirstSample, Capacity };
+	ImPlot::PlotLineG(Label, &GetPlotPoint, &Source, Count);
+}
+
+void FAVS_TelemetryDashboard::Draw()
+{
+	UVehicleSimulationSubsystem* VehicleSimulation = Simulation.Get();
+	if( !bOpen || VehicleSimulation == nullptr ) return;
+
+	ImGui::SetNextWindowSize(ImVec2(640.0f, 720.0f), ImGuiCond_FirstUseEver);
+	if( !ImGui::Begin("Vehicle Telemetry", &bOpen) )
+	{
+		ImGui::End();
+		return;
+	}
+
+	// Vehicle selection
+	const AVehicleSystemBase* Selected = VehicleSimulation->GetVehicle(VehicleId);
+	if( ImGui::BeginCombo("Vehicle", Selected ? TCHAR_TO_ANSI(*Selected->GetName()) : "None") )
+	{
+		for( int32 Id = 0; Id < VehicleSimulation->GetNumVehicleIds(); ++Id )
+		{
+			const AVehicleSystemBase* Vehicle = VehicleSimulation->GetVehicle(Id);
+			if( Vehicle == nullptr ) continue;
+
+			ImGui::PushID(Id);
+			if( ImGui::Selectable(TCHAR_TO_ANSI(*Vehicle->GetName()), Id == VehicleId) && Id != VehicleId ) SelectVehicle(Id, 0);
+			ImGui::PopID();
+		}
+		ImGui::EndCombo();
+	}
+	ImGui::SliderFloat("Window (s)", &PlotWindow, 1.0f, Capacity / 60.0f, "%.0f");
+	ImGui::Text("Samples %d / %d, telemetry records dropped %d", NumSamples, Capacity, VehicleSimulation->GetDroppedTelemetryRecords());
+
+	if( NumSamples == 0 )
+	{
+		ImGui::End();
+		return;
+	}
+
+	// Only the samples inside the window are drawn, the newest sample is at NextSample - 1
+	int32 Count = 0;
+	const float WindowStart = Time - PlotWindow;
+	while( Count < NumSamples && Times[(NextSample + Capacity - 1 - Count) % Capacity] >= WindowStart ) ++Count;
+	const int32 FirstSample = (NextSample + Capacity - Count) % Capacity;
+
+	const ImVec2 PlotSize(-1.0f, 150.0f);
+	const ImPlotAxisFlags YFlags = ImPlotAxisFlags_AutoFit;
+	auto BeginTimePlot = [&](const char* Title, const char* YLabel)
+	{
+		if( !ImPlot::BeginPlot(Title, PlotSize, ImPlotFlags_NoMenus) ) return false;
+		ImPlot::SetupAxes(nullptr, YLabel, ImPlotAxisFlags_NoTickLabels, YFlags);
+		ImPlot::SetupAxisLimits(ImAxis_X1, WindowStart, Time, ImPlotCond_Always);
+		return true;
+	};
+
+	// Wheel charts, one line per wheel
+	struct FWheelPlot { const char* Title; const char* YLabel; EWheelChannel Channel; };
+	static const FWheelPlot WheelPlots[] =
+	{
+		{ "Slip X", nullptr, SlipX },
+		{ "Slip Y", nullptr, SlipY },
+		{ "Suspension Length", "cm", SpringLength },
+		{ "Angular Velocity", "rad/s", AngularVelocity },
+		{ "Applied Force", "N", Force },
+	};
+	for( const FWheelPlot& WheelPlot : WheelPlots )
+	{
+		if( !BeginTimePlot(WheelPlot.Title, WheelPlot.YLabel) ) continue;
+		for( int32 WIndex = 0; WIndex < NumWheels; ++WIndex )
+		{
+			char Label[16];
+			FCStringAnsi::Snprintf(Label, sizeof(Label), "Wheel %d", WIndex);
+			DrawChannel(Label, NumVehicleChannels + WIndex * NumWheelChannels + WheelPlot.Channel, FirstSample, Count);
+		}
+		ImPlot::EndPlot();
+	}
+
+	// Simulation and network charts
+	if( BeginTimePlot("Chaos Delta Time", "ms") )
+	{
+		DrawChannel("Delta Time", ChaosDeltaTime, FirstSample, Count);
+		ImPlot::EndPlot();
+	}
+	if( BeginTimePlot("Network", nullptr) )
+	{
+		DrawChannel("Queue Depth", QueueDepth, FirstSample, Count);
+		DrawChannel("Error (cm)", NetError, FirstSample, Count);
+		ImPlot::EndPlot();
+	}
+
+	ImGui::End();
+}
+
+#else
+
+void FAVS_TelemetryDashboard::DrawChannel(const char* Label, int32 Channel, int32 FirstSample, int32 Count) {}
+void FAVS_TelemetryDashboard::Draw() {}
+
+#endif
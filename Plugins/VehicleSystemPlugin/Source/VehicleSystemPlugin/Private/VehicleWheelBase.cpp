@@ -6,12 +6,42 @@
 #include "AVS_DEBUG.h"
 #include "VehicleSystemFunctions.h"
 #include "Components/SphereComponent.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
 #include "VehicleSystemPlugin/VehicleSystemPlugin.h"
 
+FAVS_WheelContact::FAVS_WheelContact(const FHitResult& Hit)
+	: bBlockingHit(Hit.bBlockingHit)
+	, Distance(Hit.Distance)
+	, ImpactPoint(Hit.ImpactPoint)
+	, ImpactNormal(Hit.ImpactNormal)
+	, Component(Hit.Component)
+	, PhysMaterial(Hit.PhysMaterial)
+{
+}
+
+void FAVS_WheelContact::ResolveSurfaceType()
+{
+	SurfaceType = bBlockingHit ? UPhysicalMaterial::DetermineSurfaceType(PhysMaterial.Get()) : SurfaceType_Default;
+}
+
+FHitResult FAVS_WheelContact::ToHitResult() const
+{
+	FHitResult Hit;
+	Hit.bBlockingHit = bBlockingHit;
+	Hit.Distance = Distance;
+	Hit.Location = ImpactPoint;
+	Hit.ImpactPoint = ImpactPoint;
+	Hit.Normal = ImpactNormal;
+	Hit.ImpactNormal = ImpactNormal;
+	Hit.Component = Component;
+	Hit.PhysMaterial = PhysMaterial;
+	if( const UPrimitiveComponent* HitComponent = Component.Get() ) Hit.HitObjectHandle = FActorInstanceHandle(HitComponent->GetOwner());
+	return Hit;
+}
+
 UVehicleWheelBase::UVehicleWheelBase(): WheelStaticMesh(nullptr), WheelMeshComponent(nullptr)
 {
-	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bCanEverTick = false; // Visuals are updated by the vehicle (see AVehicleSystemBase::UpdateWheelVisuals)
 }
 
 void UVehicleWheelBase::BeginPlay()
@@ -47,15 +77,13 @@ void UVehicleWheelBase::UpdateLocalTransformCache()
 	WheelConfig.WheelLocalTransform = GetComponentTransform().GetRelativeTransform(VehicleMesh->GetBodyInstance()->GetUnrealWorldTransform());
 }
 
-void UVehicleWheelBase::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+bool UVehicleWheelBase::UpdateVisual(float DeltaTime, FTransform& OutRelativeTransform)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
 	if( WheelConfig.WheelMode != EWheelMode::Raycast )
-		return;
+		return false;
 
 	if( !IsValid(WheelMeshComponent) || !GetIsAttached() || !GetIsSimulatingSuspension() )
-		return;
+		return false;
 
 	WheelConfig.isLocked = isLocked; // Copy isLocked into wheel config every frame, TODO not ideal should be changed later
 
@@ -87,17 +115,21 @@ void UVehicleWheelBase::TickComponent(float DeltaTime, ELevelTick TickType, FAct
 	constexpr float RadsToDegreesPerSecond = (180.0f / PI);
 	const float SpringStart = WheelConfig.SpringLength*0.5f;
 	
-	// Add delta rotation
-	WheelRotation = UKismetMathLibrary::ComposeRotators(WheelRotation, FRotator(CurAngVel * RadsToDegreesPerSecond * -1.0f * DeltaTime, 0.0f, 0.0f));
-	
-	FVector NewLoc = FVector(0,0, FMath::Min(SpringStart + (WheelData.CurrentSpringLength * -1.0f), SpringStart) );
-	FRotator NewRot = UKismetMathLibrary::ComposeRotators(WheelRotation, FRotator(0.0f, GetSteeringAngle(), 0.0f));
-	WheelMeshComponent->SetRelativeLocationAndRotation(NewLoc, NewRot);
+	// Add delta rotation, the spin only ever rotates around the axle so the pitch can be accumulated directly
+	WheelRotation.Pitch = FRotator::NormalizeAxis(WheelRotation.Pitch + CurAngVel * RadsToDegreesPerSecond * -1.0f * DeltaTime);
 
-	if( PassiveMode && FMath::Abs(CurAngVel) <= 0.01f )
-	{
-		SetComponentTickEnabled(false);
-	}
+	const FVector NewLoc = FVector(0,0, FMath::Min(SpringStart + (WheelData.CurrentSpringLength * -1.0f), SpringStart) );
+	const FQuat NewRot = FRotator(0.0f, GetSteeringAngle(), 0.0f).Quaternion() * WheelRotation.Quaternion();
+
+	// Skip the write while the wheel stands still, a write propagates the transform and dirties the render state
+	if( HasVisualTransform && NewLoc.Equals(LastVisualLocation, 0.01) && NewRot.Equals(LastVisualRotation, 1.e-4f) )
+		return false;
+
+	LastVisualLocation = NewLoc;
+	LastVisualRotation = NewRot;
+	HasVisualTransform = true;
+	OutRelativeTransform = FTransform(NewRot, NewLoc);
+	return true;
 }
 
 void UVehicleWheelBase::SetWheelMode_Implementation(EWheelMode NewMode)
@@ -0,0 +1,342 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleWheelKernel.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+
+static TAutoConsoleVariable<bool> CVarAVSWheelKernelSIMD(
+	TEXT("avs.WheelKernel.SIMD"),
+	true,
+	TEXT("Solve raycast wheels 4 at a time with SIMD, 0 uses the scalar path"));
+
+void FAVS_WheelKernel::Reset()
+{
+	for( TArray<float, TAlignedHeapAllocator<16>>& Stream : Streams ) { Stream.Reset(); }
+	WheelIndex.Reset();
+	NumLanes = 0;
+}
+
+int32 FAVS_WheelKernel::AddLane(int32 InWheelIndex)
+{
+	// Streams may still hold the padding of the last solve
+	const int32 Lane = NumLanes++;
+	for( TArray<float, TAlignedHeapAllocator<16>>& Stream : Streams ) { Stream.SetNumUninitialized(NumLanes, EAllowShrinking::No); }
+	WheelIndex.Add(InWheelIndex);
+	return Lane;
+}
+
+void FAVS_WheelKernel::PadLanes()
+{
+	const int32 NumPadded = Align(NumLanes, LaneWidth);
+	for( TArray<float, TAlignedHeapAllocator<16>>& Stream : Streams ) { Stream.SetNumZeroed(NumPadded, EAllowShrinking::No); }
+
+	// Keep the padded lanes away from divisions by zero
+	for( int32 Lane = NumLanes; Lane < NumPadded; ++Lane )
+	{
+		Get(NormalZ, Lane) = 1.0f;
+		Get(ForwardX, Lane) = 1.0f;
+		Get(RightY, Lane) = 1.0f;
+		Get(UpZ, Lane) = 1.0f;
+		Get(Radius, Lane) = 1.0f;
+		Get(RadiusM, Lane) = 1.0f;
+		Get(Inertia, Lane) = 1.0f;
+	}
+}
+
+void FAVS_WheelKernel::Solve(float DeltaTime)
+{
+	if( NumLanes == 0 ) return;
+
+	if( CVarAVSWheelKernelSIMD.GetValueOnAnyThread() )
+	{
+		SolveVectorized(DeltaTime);
+	}
+	else
+	{
+		SolveScalar(DeltaTime);
+	}
+}
+
+// ** Scalar ** //
+
+void FAVS_WheelKernel::SolveScalar(float DeltaTime)
+{
+	for( int32 Lane = 0; Lane < NumLanes; ++Lane )
+	{
+		const FVector3f Normal(Get(NormalX, Lane), Get(NormalY, Lane), Get(NormalZ, Lane));
+		const FVector3f Forward(Get(ForwardX, Lane), Get(ForwardY, Lane), Get(ForwardZ, Lane));
+		const FVector3f Right(Get(RightX, Lane), Get(RightY, Lane), Get(RightZ, Lane));
+		const FVector3f Up(Get(UpX, Lane), Get(UpY, Lane), Get(UpZ, Lane));
+		const FVector3f WheelVelocityWorld(Get(VelocityX, Lane), Get(VelocityY, Lane), Get(VelocityZ, Lane));
+		const float WheelRadius = Get(Radius, Lane);
+		const float SpringLengthMax = Get(SpringLength, Lane);
+		const float WheelInertia = Get(Inertia, Lane);
+		const float EffectiveFrictionX = Get(FrictionX, Lane);
+		const float EffectiveFrictionY = Get(FrictionY, Lane);
+
+		// Length of spring right now while compressed
+		const float Length = Get(TraceDistance, Lane) - (WheelRadius * 2.0f);
+		const float NewSpringLength = FMath::Clamp(Length, 0.0f, SpringLengthMax);
+
+		// Wheel velocity, the wheel transform has no scale so its inverse is a projection onto the axes
+		const float WheelVelocityLocalX = FVector3f::DotProduct(WheelVelocityWorld, Forward);
+		const float WheelVelocityLocalZ = FVector3f::DotProduct(WheelVelocityWorld, Up);
+		const FVector3f WheelVelocityProjected = FVector3f::VectorPlaneProject(WheelVelocityWorld * 0.01f, Normal); // Meters/Second
+		const float WheelVelocityLocalMX = FVector3f::DotProduct(WheelVelocityProjected, Forward);
+		const float WheelVelocityLocalMY = FVector3f::DotProduct(WheelVelocityProjected, Right);
+
+		// Project the axes onto the plane
+		FVector3f ForwardOnPlane = FVector3f::VectorPlaneProject(Forward, Normal); ForwardOnPlane.Normalize();
+		FVector3f RightOnPlane = FVector3f::VectorPlaneProject(Right, Normal); RightOnPlane.Normalize();
+		const float WheelVelocity = WheelVelocityProjected.Size();
+		const FVector3f LinearVelocityOnPlaneNormalized = (WheelVelocity != 0.0f) ? WheelVelocityProjected / WheelVelocity : FVector3f::ZeroVector;
+
+		// Suspension
+		const float CompressionDistanceM = (SpringLengthMax - NewSpringLength) * 0.01f;
+		const float CompressionVelocityM = WheelVelocityLocalZ * (-0.01f);
+		float SpringForceN = Get(SpringStrength, Lane) * 1000.0f * CompressionDistanceM;
+		float DamperForceN = Get(SpringDamping, Lane) * 1000.0f * CompressionVelocityM;
+		if( Length < -1.0f ) // Excess compression
+		{
+			SpringForceN += Get(AntiGravity, Lane);
+			DamperForceN *= 2;
+		}
+		const float SuspensionForceN = SpringForceN + DamperForceN;
+
+		// Slip angle
+		const float ASin = FMath::Asin(FMath::Clamp(FVector3f::DotProduct(RightOnPlane, LinearVelocityOnPlaneNormalized), -1.0f, 1.0f));
+		const float SlipAngle = -ASin * (180.0f / PI);
+
+		// SlipX Target
+		const float RollingAngVel = WheelVelocityLocalX / WheelRadius;
+		float AngularVel = RollingAngVel;
+		float XSlipTarget;
+		if( Get(Locked, Lane) != 0.0f )
+		{
+			AngularVel = 0.0f;
+			XSlipTarget = FMath::Sign(-WheelVelocityLocalMX);
+		}
+		else
+		{
+			const float MaxFrictionTorque = SuspensionForceN * Get(RadiusM, Lane) * EffectiveFrictionX;
+			const float BrakeAmount = FMath::Clamp(Get(BrakeInput, Lane), Get(RollingResistance, Lane), 1.0f);
+			const float XBrakeTorque = FMath::Sign(-RollingAngVel) * Get(BrakeTorque, Lane) * BrakeAmount;
+
+			float XDriveTorqueNm = 0.0f;
+			const float InputTorque = Get(DriveTorque, Lane);
+			if( InputTorque != 0.0f )
+			{
+				const float NewAngVel = RollingAngVel + ((InputTorque*DriveTorqueToNm) / WheelInertia * DeltaTime);
+				XDriveTorqueNm = (NewAngVel - RollingAngVel) / DeltaTime * WheelInertia;
+			}
+			XSlipTarget = (XBrakeTorque + XDriveTorqueNm) / MaxFrictionTorque;
+		}
+
+		// Interpolate slip to target
+		float NewSlipX = Get(SlipX, Lane);
+		const float InterpSpeedLong = FMath::Clamp(FMath::Abs(WheelVelocityLocalMX) / 0.010f * DeltaTime, 0.0f, 1.0f);
+		NewSlipX += (XSlipTarget - NewSlipX) * InterpSpeedLong;
+		NewSlipX = FMath::Clamp(NewSlipX, -30.0f, 30.0f);
+
+		const float YSlipTargetHighSpeed = SlipAngle / 12.0f;
+		const float YSlipTargetLowSpeed = -FMath::Sign(WheelVelocityLocalMY);
+		const float Alpha = FMath::Clamp(WheelVelocity - 1.0f, 0.0f, 1.0f);
+		const float YSlipTarget = FMath::Lerp(YSlipTargetLowSpeed, YSlipTargetHighSpeed, Alpha);
+
+		float NewSlipY = Get(SlipY, Lane);
+		const float InterpSpeedLat = FMath::Clamp(FMath::Abs(WheelVelocityLocalMY) / 0.007f * DeltaTime, 0.0f, 1.0f);
+		NewSlipY += (YSlipTarget - NewSlipY) * InterpSpeedLat;
+
+		Get(SlipX, Lane) = NewSlipX;
+		Get(SlipY, Lane) = NewSlipY;
+
+		// Normalized slip for the final force
+		const float SlipLength = FMath::Sqrt(NewSlipX*NewSlipX + NewSlipY*NewSlipY);
+		if( SlipLength > 1.0f )
+		{
+			NewSlipX /= SlipLength;
+			NewSlipY /= SlipLength;
+		}
+		NewSlipY = FMath::Sign(NewSlipY) * FMath::Sqrt(FMath::Abs(NewSlipY));
+
+		const FVector3f Traction = ForwardOnPlane * NewSlipX * EffectiveFrictionX + RightOnPlane * NewSlipY * EffectiveFrictionY;
+		const FVector3f FinalWheelForce = (Normal * SuspensionForceN + Traction * SuspensionForceN) * 100.0f; // CentiNewtons
+
+		Get(ForceX, Lane) = FinalWheelForce.X;
+		Get(ForceY, Lane) = FinalWheelForce.Y;
+		Get(ForceZ, Lane) = FinalWheelForce.Z;
+		Get(CurrentSpringLength, Lane) = NewSpringLength;
+		Get(AngularVelocity, Lane) = AngularVel;
+	}
+}
+
+// ** Vectorized ** //
+
+namespace AVSWheelKernel
+{
+	typedef VectorRegister4Float VReg;
+
+	FORCEINLINE VReg Dot3(const VReg& AX, const VReg& AY, const VReg& AZ, const VReg& BX, const VReg& BY, const VReg& BZ)
+	{
+		return VectorMultiplyAdd(AX, BX, VectorMultiplyAdd(AY, BY, VectorMultiply(AZ, BZ)));
+	}
+
+	FORCEINLINE VReg Clamp(const VReg& V, const VReg& Min, const VReg& Max)
+	{
+		return VectorMin(VectorMax(V, Min), Max);
+	}
+
+	// FMath::Sign, zero stays zero
+	FORCEINLINE VReg Sign(const VReg& V)
+	{
+		const VReg Zero = VectorZeroFloat();
+		const VReg Positive = VectorSelect(VectorCompareGT(V, Zero), VectorOneFloat(), Zero);
+		const VReg Negative = VectorSelect(VectorCompareLT(V, Zero), VectorOneFloat(), Zero);
+		return VectorSubtract(Positive, Negative);
+	}
+
+	// V - N * (V|N)
+	FORCEINLINE void PlaneProject(VReg& X, VReg& Y, VReg& Z, const VReg& NX, const VReg& NY, const VReg& NZ)
+	{
+		const VReg Dot = Dot3(X, Y, Z, NX, NY, NZ);
+		X = VectorNegateMultiplyAdd(NX, Dot, X);
+		Y = VectorNegateMultiplyAdd(NY, Dot, Y);
+		Z = VectorNegateMultiplyAdd(NZ, Dot, Z);
+	}
+
+	// FVector::Normalize, vectors that are too small are left as they are
+	FORCEINLINE void Normalize(VReg& X, VReg& Y, VReg& Z)
+	{
+		const VReg SizeSquared = Dot3(X, Y, Z, X, Y, Z);
+		const VReg Mask = VectorCompareGT(SizeSquared, VectorSetFloat1(UE_SMALL_NUMBER));
+		const VReg InvSize = VectorDivide(VectorOneFloat(), VectorSqrt(VectorSelect(Mask, SizeSquared, VectorOneFloat())));
+		X = VectorSelect(Mask, VectorMultiply(X, InvSize), X);
+		Y = VectorSelect(Mask, VectorMultiply(Y, InvSize), Y);
+		Z = VectorSelect(Mask, VectorMultiply(Z, InvSize), Z);
+	}
+}
+
+void FAVS_WheelKernel::SolveVectorized(float DeltaTime)
+{
+	using namespace AVSWheelKernel;
+
+	PadLanes();
+
+	const VReg Zero = VectorZeroFloat();
+	const VReg One = VectorOneFloat();
+	const VReg Delta = VectorSetFloat1(DeltaTime);
+	const VReg CentiScale = VectorSetFloat1(0.01f);
+	const VReg HundredScale = VectorSetFloat1(100.0f);
+	const VReg DriveScale = VectorSetFloat1(DriveTorqueToNm);
+	const VReg KiloScale = VectorSetFloat1(1000.0f);
+
+	const int32 NumPadded = Align(NumLanes, LaneWidth);
+	for( int32 Lane = 0; Lane < NumPadded; Lane += LaneWidth )
+	{
+		auto Load = [this, Lane](EStream Stream) { return VectorLoadAligned(&Streams[Stream][Lane]); };
+		auto Store = [this, Lane](EStream Stream, const VReg& Value) { VectorStoreAligned(Value, &Streams[Stream][Lane]); };
+
+		const VReg NX = Load(NormalX), NY = Load(NormalY), NZ = Load(NormalZ);
+		const VReg FX = Load(ForwardX), FY = Load(ForwardY), FZ = Load(ForwardZ);
+		const VReg RX = Load(RightX), RY = Load(RightY), RZ = Load(RightZ);
+		const VReg VX = Load(VelocityX), VY = Load(VelocityY), VZ = Load(VelocityZ);
+		const VReg WheelRadius = Load(Radius);
+		const VReg SpringLengthMax = Load(SpringLength);
+		const VReg WheelInertia = Load(Inertia);
+		const VReg EffectiveFrictionX = Load(FrictionX);
+		const VReg EffectiveFrictionY = Load(FrictionY);
+
+		// Spring length
+		const VReg Length = VectorSubtract(Load(TraceDistance), VectorAdd(WheelRadius, WheelRadius));
+		const VReg NewSpringLength = Clamp(Length, Zero, SpringLengthMax);
+
+		// Wheel velocity
+		const VReg WheelVelocityLocalX = Dot3(VX, VY, VZ, FX, FY, FZ);
+		const VReg WheelVelocityLocalZ = Dot3(VX, VY, VZ, Load(UpX), Load(UpY), Load(UpZ));
+		VReg PX = VectorMultiply(VX, CentiScale), PY = VectorMultiply(VY, CentiScale), PZ = VectorMultiply(VZ, CentiScale);
+		PlaneProject(PX, PY, PZ, NX, NY, NZ);
+		const VReg WheelVelocityLocalMX = Dot3(PX, PY, PZ, FX, FY, FZ);
+		const VReg WheelVelocityLocalMY = Dot3(PX, PY, PZ, RX, RY, RZ);
+
+		// Axes on the plane
+		VReg FPX = FX, FPY = FY, FPZ = FZ;
+		PlaneProject(FPX, FPY, FPZ, NX, NY, NZ);
+		Normalize(FPX, FPY, FPZ);
+		VReg RPX = RX, RPY = RY, RPZ = RZ;
+		PlaneProject(RPX, RPY, RPZ, NX, NY, NZ);
+		Normalize(RPX, RPY, RPZ);
+
+		const VReg WheelVelocity = VectorSqrt(Dot3(PX, PY, PZ, PX, PY, PZ));
+		const VReg MovingMask = VectorCompareNE(WheelVelocity, Zero);
+		const VReg InvWheelVelocity = VectorSelect(MovingMask, VectorDivide(One, VectorSelect(MovingMask, WheelVelocity, One)), Zero);
+
+		// Suspension
+		const VReg CompressionDistanceM = VectorMultiply(VectorSubtract(SpringLengthMax, NewSpringLength), CentiScale);
+		const VReg CompressionVelocityM = VectorMultiply(WheelVelocityLocalZ, VectorNegate(CentiScale));
+		VReg SpringForceN = VectorMultiply(VectorMultiply(Load(SpringStrength), KiloScale), CompressionDistanceM);
+		VReg DamperForceN = VectorMultiply(VectorMultiply(Load(SpringDamping), KiloScale), CompressionVelocityM);
+		const VReg ExcessMask = VectorCompareLT(Length, VectorNegate(One));
+		SpringForceN = VectorSelect(ExcessMask, VectorAdd(SpringForceN, Load(AntiGravity)), SpringForceN);
+		DamperForceN = VectorSelect(ExcessMask, VectorAdd(DamperForceN, DamperForceN), DamperForceN);
+		const VReg SuspensionForceN = VectorAdd(SpringForceN, DamperForceN);
+
+		// Slip angle
+		const VReg SlipDot = VectorMultiply(Dot3(RPX, RPY, RPZ, PX, PY, PZ), InvWheelVelocity);
+		const VReg SlipAngle = VectorMultiply(VectorASin(Clamp(SlipDot, VectorNegate(One), One)), VectorSetFloat1(-180.0f / PI));
+
+		// SlipX Target, locked wheels and free wheels are both solved and selected
+		const VReg LockedMask = VectorCompareNE(Load(Locked), Zero);
+		const VReg RollingAngVel = VectorDivide(WheelVelocityLocalX, WheelRadius);
+
+		const VReg MaxFrictionTorque = VectorMultiply(VectorMultiply(SuspensionForceN, Load(RadiusM)), EffectiveFrictionX);
+		const VReg BrakeAmount = Clamp(Load(BrakeInput), Load(RollingResistance), One);
+		const VReg XBrakeTorque = VectorMultiply(VectorMultiply(Sign(VectorNegate(RollingAngVel)), Load(BrakeTorque)), BrakeAmount);
+
+		const VReg InputTorque = Load(DriveTorque);
+		const VReg NewAngVel = VectorAdd(RollingAngVel, VectorMultiply(VectorDivide(VectorMultiply(InputTorque, DriveScale), WheelInertia), Delta));
+		const VReg XDriveTorqueNm = VectorSelect(VectorCompareNE(InputTorque, Zero),
+			VectorMultiply(VectorDivide(VectorSubtract(NewAngVel, RollingAngVel), Delta), WheelInertia), Zero);
+
+		const VReg FreeSlipTarget = VectorDivide(VectorAdd(XBrakeTorque, XDriveTorqueNm), MaxFrictionTorque);
+		const VReg XSlipTarget = VectorSelect(LockedMask, Sign(VectorNegate(WheelVelocityLocalMX)), FreeSlipTarget);
+		const VReg AngularVel = VectorSelect(LockedMask, Zero, RollingAngVel);
+
+		// Interpolate slip to target
+		VReg NewSlipX = Load(SlipX);
+		const VReg InterpSpeedLong = Clamp(VectorMultiply(VectorDivide(VectorAbs(WheelVelocityLocalMX), VectorSetFloat1(0.010f)), Delta), Zero, One);
+		NewSlipX = VectorMultiplyAdd(VectorSubtract(XSlipTarget, NewSlipX), InterpSpeedLong, NewSlipX);
+		NewSlipX = Clamp(NewSlipX, VectorSetFloat1(-30.0f), VectorSetFloat1(30.0f));
+
+		const VReg YSlipTargetHighSpeed = VectorDivide(SlipAngle, VectorSetFloat1(12.0f));
+		const VReg YSlipTargetLowSpeed = VectorNegate(Sign(WheelVelocityLocalMY));
+		const VReg Alpha = Clamp(VectorSubtract(WheelVelocity, One), Zero, One);
+		const VReg YSlipTarget = VectorMultiplyAdd(VectorSubtract(YSlipTargetHighSpeed, YSlipTargetLowSpeed), Alpha, YSlipTargetLowSpeed);
+
+		VReg NewSlipY = Load(SlipY);
+		const VReg InterpSpeedLat = Clamp(VectorMultiply(VectorDivide(VectorAbs(WheelVelocityLocalMY), VectorSetFloat1(0.007f)), Delta), Zero, One);
+		NewSlipY = VectorMultiplyAdd(VectorSubtract(YSlipTarget, NewSlipY), InterpSpeedLat, NewSlipY);
+
+		Store(SlipX, NewSlipX);
+		Store(SlipY, NewSlipY);
+
+		// Normalized slip for the final force
+		const VReg SlipLength = VectorSqrt(VectorMultiplyAdd(NewSlipX, NewSlipX, VectorMultiply(NewSlipY, NewSlipY)));
+		const VReg OverMask = VectorCompareGT(SlipLength, One);
+		const VReg InvSlipLength = VectorDivide(One, VectorSelect(OverMask, SlipLength, One));
+		NewSlipX = VectorSelect(OverMask, VectorMultiply(NewSlipX, InvSlipLength), NewSlipX);
+		NewSlipY = VectorSelect(OverMask, VectorMultiply(NewSlipY, InvSlipLength), NewSlipY);
+		NewSlipY = VectorMultiply(Sign(NewSlipY), VectorSqrt(VectorAbs(NewSlipY)));
+
+		// Suspension along the normal plus traction along the plane axes
+		const VReg TractionX = VectorMultiply(NewSlipX, EffectiveFrictionX);
+		const VReg TractionY = VectorMultiply(NewSlipY, EffectiveFrictionY);
+		const VReg ForceScale = VectorMultiply(SuspensionForceN, HundredScale);
+		Store(ForceX, VectorMultiply(VectorMultiplyAdd(FPX, TractionX, VectorMultiplyAdd(RPX, TractionY, NX)), ForceScale));
+		Store(ForceY, VectorMultiply(VectorMultiplyAdd(FPY, TractionX, VectorMultiplyAdd(RPY, TractionY, NY)), ForceScale));
+		Store(ForceZ, VectorMultiply(VectorMultiplyAdd(FPZ, TractionX, VectorMultiplyAdd(RPZ, TractionY, NZ)), ForceScale));
+		Store(CurrentSpringLength, NewSpringLength);
+		Store(AngularVelocity, AngularVel);
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleWheelQuery.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "Chaos/PhysicsObjectInternalInterface.h"
+
+void FAVS_WheelQueryBatch::Reset()
+{
+	TraceStart.Reset();
+	TraceEnd.Reset();
+	TraceChannel.Reset();
+	ParamsIndex.Reset();
+	Hits.Reset();
+	QueryParams.Reset();
+}
+
+int32 FAVS_WheelQueryBatch::AddQueryParams(uint32 IgnoredVehicleId, const TArray<uint32>& IgnoredActorIds)
+{
+	// Matches the settings UKismetSystemLibrary::LineTraceSingle used (complex trace, ignore self, return physical material)
+	FCollisionQueryParams& Params = QueryParams.Emplace_GetRef(SCENE_QUERY_STAT(AVS_WheelTrace), true);
+	Params.bReturnPhysicalMaterial = true;
+	Params.AddIgnoredActor(IgnoredVehicleId);
+	for( const uint32 IgnoredActorId : IgnoredActorIds ) { Params.AddIgnoredActor(IgnoredActorId); }
+	return QueryParams.Num() - 1;
+}
+
+int32 FAVS_WheelQueryBatch::AddQuery(const FVector& Start, const FVector& End, ECollisionChannel Channel, int32 InParamsIndex)
+{
+	TraceStart.Add(Start);
+	TraceEnd.Add(End);
+	TraceChannel.Add(Channel);
+	ParamsIndex.Add(InParamsIndex);
+	return TraceStart.Num() - 1;
+}
+
+void FAVS_WheelQueryBatch::Resolve(const UWorld* World, bool bParallel)
+{
+	const int32 NumQueries = TraceStart.Num();
+	Hits.SetNum(NumQueries, EAllowShrinking::No);
+	if( World == nullptr ) return;
+
+	// Scene queries only read the acceleration structure, every query writes its own hit
+	ParallelFor(NumQueries, [this, World](int32 Index)
+	{
+		FHitResult& Hit = Hits[Index];
+		Hit.Init(TraceStart[Index], TraceEnd[Index]);
+		World->LineTraceSingleByChannel(Hit, TraceStart[Index], TraceEnd[Index], TraceChannel[Index], QueryParams[ParamsIndex[Index]]);
+	}, bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+void FAVS_WheelContactCache::Store(const FHitResult& Trace)
+{
+	Chaos::FGeometryParticleHandle* HitParticle = Trace.bBlockingHit ? Chaos::FPhysicsObjectInternalInterface::GetParticle(Trace.PhysicsObject) : nullptr;
+	if( HitParticle == nullptr || HitParticle->ObjectState() != Chaos::EObjectStateType::Static )
+	{
+		Invalidate();
+		return;
+	}
+
+	Hit = Trace;
+	TraceStart = Trace.TraceStart;
+	TraceEnd = Trace.TraceEnd;
+	Particle = HitParticle->WeakParticleHandle();
+	ParticleTransform = FTransform(HitParticle->GetR(), HitParticle->GetX());
+	NumReuses = 0;
+	bValid = true;
+}
+
+bool FAVS_WheelContactCache::Reproject(const FVector& Start, const FVector& End, float Tolerance)
+{
+	if( !bValid || NumReuses >= MaxReuses ) return false;
+
+	// Compared against the traced ray so small moves can't add up
+	if( !FVector::PointsAreNear(Start, TraceStart, Tolerance) || !FVector::PointsAreNear(End, TraceEnd, Tolerance) ) return false;
+
+	const Chaos::FGeometryParticleHandle* HitParticle = Particle.GetHandleUnsafe(); // Safe on the physics thread, where particles are destroyed
+	if( HitParticle == nullptr || !FTransform(HitParticle->GetR(), HitParticle->GetX()).Equals(ParticleTransform, Tolerance) ) return false;
+
+	// Intersect the ray with the contact plane
+	const FVector Ray = End - Start;
+	const double RayDotNormal = FVector::DotProduct(Ray, Hit.ImpactNormal);
+	if( FMath::IsNearlyZero(RayDotNormal) ) return false;
+
+	const double Time = FVector::DotProduct(Hit.ImpactPoint - Start, Hit.ImpactNormal) / RayDotNormal;
+	if( Time < 0.0 || Time > 1.0 ) return false;
+
+	Hit.TraceStart = Start;
+	Hit.TraceEnd = End;
+	Hit.Time = static_cast<float>(Time);
+	Hit.Distance = static_cast<float>(Ray.Size() * Time);
+	Hit.Location = Start + Ray * Time;
+	Hit.ImpactPoint = Hit.Location;
+	++NumReuses;
+	return true;
+}
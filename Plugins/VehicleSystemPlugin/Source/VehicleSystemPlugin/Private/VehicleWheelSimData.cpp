@@ -0,0 +1,100 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#include "VehicleWheelSimData.h"
+
+#include "VehicleWheelBase.h"
+#include "Components/PrimitiveComponent.h"
+
+void FAVS_WheelSimData::Reset()
+{
+	LocalTransform.Reset();
+	Radius.Reset();
+	RadiusM.Reset();
+	SpringLength.Reset();
+	SpringStrength.Reset();
+	SpringDamping.Reset();
+	Inertia.Reset();
+	FrictionX.Reset();
+	FrictionY.Reset();
+	MaxSteeringAngle.Reset();
+	BrakeTorque.Reset();
+	RollingResistance.Reset();
+	Flags.Reset();
+}
+
+void FAVS_WheelSimData::Reserve(int32 NumWheels)
+{
+	LocalTransform.Reserve(NumWheels);
+	Radius.Reserve(NumWheels);
+	RadiusM.Reserve(NumWheels);
+	SpringLength.Reserve(NumWheels);
+	SpringStrength.Reserve(NumWheels);
+	SpringDamping.Reserve(NumWheels);
+	Inertia.Reserve(NumWheels);
+	FrictionX.Reserve(NumWheels);
+	FrictionY.Reserve(NumWheels);
+	MaxSteeringAngle.Reserve(NumWheels);
+	BrakeTorque.Reserve(NumWheels);
+	RollingResistance.Reserve(NumWheels);
+	Flags.Reserve(NumWheels);
+}
+
+void FAVS_WheelSimData::Add(const FAVS1_Wheel_Config& WheelConfig)
+{
+	LocalTransform.Add(WheelConfig.WheelLocalTransform);
+	Radius.Add(WheelConfig.WheelRadius);
+	RadiusM.Add(WheelConfig.WheelRadius * 0.01f); // WheelRadiusM is not refreshed when the radius is updated from the mesh
+	SpringLength.Add(WheelConfig.SpringLength);
+	SpringStrength.Add(WheelConfig.SpringStrength);
+	SpringDamping.Add(WheelConfig.SpringDamping);
+	Inertia.Add(WheelConfig.Inertia);
+	FrictionX.Add(WheelConfig.TireFriction.X);
+	FrictionY.Add(WheelConfig.TireFriction.Y);
+	MaxSteeringAngle.Add(WheelConfig.MaxSteeringAngle);
+	BrakeTorque.Add(WheelConfig.BrakeTorque);
+	RollingResistance.Add(WheelConfig.RollingResistance);
+
+	EAVS_WheelFlags WheelFlags = EAVS_WheelFlags::None;
+	if( WheelConfig.IsDrivingWheel ) WheelFlags |= EAVS_WheelFlags::Driving;
+	if( WheelConfig.IsSteerableWheel ) WheelFlags |= EAVS_WheelFlags::Steerable;
+	if( WheelConfig.InvertTorque ) WheelFlags |= EAVS_WheelFlags::InvertTorque;
+	if( WheelConfig.InvertSteering ) WheelFlags |= EAVS_WheelFlags::InvertSteering;
+	if( WheelConfig.IsBrakingWheel ) WheelFlags |= EAVS_WheelFlags::Braking;
+	if( WheelConfig.IsHandbrakeWheel ) WheelFlags |= EAVS_WheelFlags::Handbrake;
+	if( WheelConfig.isLocked ) WheelFlags |= EAVS_WheelFlags::Locked;
+	if( WheelConfig.WheelMode == EWheelMode::Physics ) WheelFlags |= EAVS_WheelFlags::PhysicsMode;
+	Flags.Add(WheelFlags);
+}
+
+void FAVS_WheelColdBlock::Add(const FAVS1_Wheel_Config& WheelConfig)
+{
+	FAVS_WheelColdData& ColdData = Wheels.AddDefaulted_GetRef();
+	ColdData.WheelProxy = GetWheelProxy(WheelConfig);
+	ColdData.TraceChannel = WheelConfig.TraceChannel;
+	for( const AActor* IgnoredActor : WheelConfig.TraceIgnoreActors )
+	{
+		if( IsValid(IgnoredActor) ) ColdData.TraceIgnoreActorIds.Add(IgnoredActor->GetUniqueID());
+	}
+	ColdData.bNewQueryParams = (Wheels.Num() == 1) || (Wheels.Last(1).TraceIgnoreActorIds != ColdData.TraceIgnoreActorIds);
+}
+
+uint32 FAVS_WheelColdBlock::GetColdHash(const FAVS1_Wheel_Config& WheelConfig)
+{
+	uint32 Hash = GetTypeHash(WheelConfig.WheelPrim);
+	Hash = HashCombineFast(Hash, GetTypeHash(GetWheelProxy(WheelConfig))); // Body is recreated when the wheel mode or mesh changes
+	Hash = HashCombineFast(Hash, GetTypeHash(WheelConfig.TraceChannel.GetValue()));
+	for( const AActor* IgnoredActor : WheelConfig.TraceIgnoreActors )
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(IgnoredActor));
+	}
+	return HashCombineFast(Hash, WheelConfig.TraceIgnoreActors.Num());
+}
+
+Chaos::FSingleParticlePhysicsProxy* FAVS_WheelColdBlock::GetWheelProxy(const FAVS1_Wheel_Config& WheelConfig)
+{
+	if( !IsValid(WheelConfig.WheelPrim) ) return nullptr;
+
+	const FBodyInstance* BodyInstance = WheelConfig.WheelPrim->GetBodyInstance();
+	return BodyInstance ? BodyInstance->GetPhysicsActorHandle() : nullptr;
+}
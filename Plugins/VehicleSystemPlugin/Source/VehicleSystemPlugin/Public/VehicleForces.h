@@ -0,0 +1,52 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Chaos
+{
+	class FRigidBodyHandle_Internal;
+}
+
+/**
+ * Physics handle writes made while simulating one vehicle.
+ * Forces are summed per body with their moment, so each body gets a single force and torque write per substep.
+ * Vehicles only record them so they can be ticked on worker threads, every vehicle is then applied in one serial pass.
+ */
+struct VEHICLESYSTEMPLUGIN_API FAVS_VehicleForces
+{
+	void Reset();
+
+	void AddForceAtLocation(Chaos::FRigidBodyHandle_Internal* Target, const FVector& Location, const FVector& Force);
+	void AddForce(Chaos::FRigidBodyHandle_Internal* Target, const FVector& Force);
+	void AddBrakes(Chaos::FRigidBodyHandle_Internal* Target, float BrakeTorque, float DeltaTime);
+
+	// Physics thread only, applies and clears the recorded forces. Returns the number of handle writes
+	int32 Apply();
+
+	// Recorded force and torque of a body, zero if nothing was recorded for it
+	void GetBodyForces(const Chaos::FRigidBodyHandle_Internal* Target, FVector& OutForce, FVector& OutTorque) const;
+
+private:
+	struct FBodyForces
+	{
+		Chaos::FRigidBodyHandle_Internal* Target = nullptr;
+		FVector CenterOfMass = FVector::ZeroVector; // World space, resolved once per substep
+		FVector Force = FVector::ZeroVector; // Every force, applied at the center of mass
+		FVector Torque = FVector::ZeroVector; // Sum of (Location - CenterOfMass) x Force of the located forces
+	};
+
+	struct FBrakes
+	{
+		Chaos::FRigidBodyHandle_Internal* Target;
+		float BrakeTorque;
+		float DeltaTime;
+	};
+
+	TArray<FBodyForces, TInlineAllocator<8>> Bodies; // Vehicle body and physics wheels
+	TArray<FBrakes, TInlineAllocator<4>> Brakes; // Depend on the wheel's angular velocity, applied as they are
+
+	FBodyForces& GetBody(Chaos::FRigidBodyHandle_Internal* Target);
+};
@@ -0,0 +1,54 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "VehicleSystemBase.h"
+#include "VehicleNetRelayComponent.generated.h"
+
+USTRUCT()
+struct FAVS_NetStateRelayEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AVehicleSystemBase* Vehicle = nullptr;
+	UPROPERTY()
+	FNetState State;
+};
+
+/**
+ * Added to every remote player controller by the server when it logs in.
+ * While avs.Net.BatchRelay is enabled, vehicle states relayed during a frame are sent to the connection in one batch instead of a multicast per vehicle.
+ * Batches are only sent once the client reported its copy of the component, earlier RPCs would have nothing to resolve to.
+ */
+UCLASS(ClassGroup=(VehicleSystemPlugin))
+class VEHICLESYSTEMPLUGIN_API UVehicleNetRelayComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UVehicleNetRelayComponent();
+
+	// Most entries sent per RPC, larger batches are split
+	static constexpr int32 MaxBatchSize = 32;
+
+	// Server only, the client's copy exists and can receive batches
+	bool IsClientReady() const { return bClientReady; }
+
+	UFUNCTION(Client, unreliable)
+	void Client_ReceiveNetStates(const TArray<FAVS_NetStateRelayEntry>& States);
+	virtual void Client_ReceiveNetStates_Implementation(const TArray<FAVS_NetStateRelayEntry>& States);
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	bool bClientReady = false;
+
+	UFUNCTION(Server, reliable)
+	void Server_NotifyClientReady();
+	virtual void Server_NotifyClientReady_Implementation();
+};
@@ -4,58 +4,282 @@
 #pragma once
 
 #include "VehicleWheelBase.h"
+#include "VehicleForces.h"
+#include "VehicleTelemetry.h"
+#include "VehicleWheelKernel.h"
+#include "VehicleWheelQuery.h"
+#include "VehicleWheelSimData.h"
+#include "Containers/TripleBuffer.h"
 #include "PhysicsProxy/SingleParticlePhysicsProxy.h"
 #include "Runtime/Launch/Resources/Version.h"
 
-struct FVehiclePhysicsPhysicsInput : public Chaos::FSimCallbackInput
+// How the physics thread numbers the substeps of a NetServerAuthoritative vehicle
+enum class EVehicleInputFrames : uint8
 {
-	TWeakObjectPtr<UWorld> World;
-	
-	TWeakObjectPtr<APawn> VehicleActor; //Has to be a pawn to avoid circular references
-	UPrimitiveComponent* VehicleMeshPrim;
+	None,
+	Predict, // Owner: every substep is a new frame simulated with the game thread inputs
+	Replay // Server: every substep simulates the next frame received from the owner, in order
+};
+
+// One simulated input frame and the body state the substep ended with
+struct FVehiclePhysicsInputRecord
+{
+	uint32 Frame = 0;
+	FAVS_Inputs Inputs;
+	float DeltaTime = 0.0f; // Substep the frame was simulated with
+	FVector Position = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector Velocity = FVector::ZeroVector; // cm/s
+	FVector AngularVelocity = FVector::ZeroVector; // rad/s
+	bool bComplete = false; // The body state is only known once the next substep starts
+};
+
+// Data sent to the physics thread for a single vehicle each game tick
+struct FVehiclePhysicsVehicleInput
+{
+	int32 VehicleId = INDEX_NONE; // Slot of the vehicle in the simulation manager
+	uint32 VehicleSerial = 0; // Changes whenever a slot is reused
+
+	bool bContactsOnly = false; // Dormant vehicle the game thread skips, only its contact filter is kept
+
+	uint32 VehicleActorId = 0; // Unique ID of the vehicle actor, used to ignore itself in wheel traces
 	float VehicleMass = 0.0f;
 
 	FAVS_Inputs VehicleInputs;
-	
-	TArray<FAVS1_Wheel_Config> Wheels;
+	EVehicleInputFrames InputFrameMode = EVehicleInputFrames::None;
+	uint32 InputFrameEpoch = 0; // Physics thread drops its queued frames when this changes
+	TArray<FAVS_InputFrame> InputFrames; // Replay: received frames, resent until the output reports them queued
+	int32 InputHistorySize = 0; // Predict: frames kept by the physics thread so corrections can be replayed
+
+	// Predict: server state of an earlier frame, the physics thread rewinds the body to it and replays the frames simulated since
+	uint32 CorrectionId = 0; // Applied once, whenever it changes
+	FVehiclePhysicsInputRecord Correction;
+
+	EVehicleSimulationLOD SimulationLOD = EVehicleSimulationLOD::LOD0;
+
+	// Wheel contact cache, contacts are reused below this speed while the wheel rays move less than the tolerance
+	float ContactCacheMaxSpeed = 0.0f; // cm/s
+	float ContactCacheTolerance = 0.0f; // cm, zero disables the cache
+
+	// Dormancy, the body is put to sleep after resting for DormancyDelay and skipped until it is woken
+	float DormancyDelay = 0.0f; // Seconds, zero disables dormancy
+	float DormancySleepSpeed = 0.0f; // cm/s, resting below this
+	float DormancyWakeSpeed = 0.0f; // cm/s, the rest timer only restarts above this
+	float DormancySleepAngularSpeed = 0.0f; // deg/s
+	float DormancyWakeAngularSpeed = 0.0f; // deg/s
+	bool bDormancyWake = false; // Game thread has input for the vehicle, wakes it
+
+	FAVS_WheelSimData Wheels; // Hot wheel data, rebuilt every tick
+	FAVS_WheelColdBlockPtr ColdWheels; // Cold wheel data, shared until a wheel changes
+
+	// Vehicle mesh body, also used by contact modification: collisions between it and these are disabled
+	Chaos::FSingleParticlePhysicsProxy* VehicleProxy = nullptr;
+	TArray<Chaos::FSingleParticlePhysicsProxy*> ContactModProxies;
+};
+
+struct FVehiclePhysicsPhysicsInput : public Chaos::FSimCallbackInput
+{
+	TWeakObjectPtr<UWorld> World;
+	bool bTelemetry = false; // A debug view is draining the telemetry ring
+	bool bSubstepTimes = false; // A tool is draining the simulate time of every substep from the telemetry ring
+	FAVS_SurfaceFrictionTablePtr SurfaceFrictions;
+
+	// Vehicle entries are kept alive between inputs so their arrays keep their memory, only the first NumVehicles are valid
+	TArray<FVehiclePhysicsVehicleInput> Vehicles;
+	int32 NumVehicles = 0;
+
+	FVehiclePhysicsVehicleInput& AddVehicle()
+	{
+		if( NumVehicles == Vehicles.Num() ) { Vehicles.AddDefaulted(); }
+		return Vehicles[NumVehicles++];
+	}
 
 	void Reset() //Required
 	{
-		VehicleActor = nullptr;
-		VehicleMeshPrim = nullptr;
-		VehicleMass = 0.0f;
-		Wheels.Reset();
+		NumVehicles = 0;
 		World.Reset();
+		SurfaceFrictions.Reset();
 	}
-}; 
-struct FVehiclePhysicsPhysicsOutput : public Chaos::FSimCallbackOutput
+};
+
+// Data output from the physics thread for a single vehicle
+struct FVehiclePhysicsVehicleOutput
+{
+	int32 VehicleId = INDEX_NONE;
+	uint32 VehicleSerial = 0;
+
+	TArray<FAVS1_Wheel_Output> WheelOutputs; // Indexed by wheel
+
+	bool bDormant = false; // Vehicle was skipped, the game thread can stop sending inputs until its body wakes
+
+	// Input frames of NetServerAuthoritative vehicles, see EVehicleInputFrames
+	uint32 InputFrameEpoch = 0;
+	uint32 LastQueuedInputFrame = 0; // Replay: newest received frame the physics thread holds
+	TArray<FVehiclePhysicsInputRecord> InputRecords; // Most recent frames simulated, oldest first
+	uint32 CorrectionId = 0; // Predict: last correction the physics thread handled
+
+	// Clears the output, keeps allocations
+	void Reset()
+	{
+		bDormant = false;
+		WheelOutputs.Reset();
+		InputFrameEpoch = 0;
+		LastQueuedInputFrame = 0;
+		InputRecords.Reset();
+		CorrectionId = 0;
+	}
+};
+
+/**
+ * Output of every vehicle for one physics step, passed to the game thread through a triple buffer.
+ * Snapshots are reused so their arrays keep their memory, only the first NumVehicles entries are valid.
+ */
+struct FVehiclePhysicsOutputSnapshot
 {
 	float ChaosDeltaTime = 0.0f;
-	
-	// Raycast wheel data
-	TArray<FHitResult> DebugTraces; // Raw trace data generated on physics thread
-	TArray<FDebugForce> DebugForces; // Forces applied to the vehicle
-	TArray<FString> DebugTexts;
-	
-	TArray<FAVS1_Wheel_Output> WheelOutputs;
-	
-	void Reset() //Required
+	uint64 SimulateCycles = 0; // Time spent simulating the vehicles of this step
+
+	TArray<FVehiclePhysicsVehicleOutput> Vehicles;
+	int32 NumVehicles = 0;
+
+	FVehiclePhysicsVehicleOutput& AddVehicle(int32 VehicleId, uint32 VehicleSerial)
+	{
+		if( NumVehicles == Vehicles.Num() ) { Vehicles.AddDefaulted(); }
+		FVehiclePhysicsVehicleOutput& VehicleOutput = Vehicles[NumVehicles++];
+		VehicleOutput.Reset();
+		VehicleOutput.VehicleId = VehicleId;
+		VehicleOutput.VehicleSerial = VehicleSerial;
+		return VehicleOutput;
+	}
+
+	void Reset()
 	{
 		ChaosDeltaTime = 0.0f;
-		DebugTraces.Empty();
-		DebugForces.Empty();
-		DebugTexts.Empty();
-		WheelOutputs.Empty();
+		SimulateCycles = 0;
+		NumVehicles = 0;
+	}
+};
+
+// Required by the sim callback, vehicle outputs are passed through the callback's output triple buffer instead
+struct FVehiclePhysicsPhysicsOutput : public Chaos::FSimCallbackOutput
+{
+	void Reset() //Required
+	{
 	}
 };
 
-// Unreal 5.1+ Physics Callback
+// Physics thread state of a single vehicle, persists between substeps
+struct FVehiclePhysicsVehicleState
+{
+	uint32 VehicleSerial = 0;
+
+	TArray<FAVS1_Wheel_State> WheelStates;
+	TArray<FTransform> WheelWorldTransforms; // Indexed by wheel, calculated while gathering wheel queries
+	TArray<int32> WheelQueryIndices; // Index of each wheel in the shared query batch, INDEX_NONE when the cached contact is reused
+	TArray<FAVS_WheelContactCache> ContactCaches; // Indexed by wheel
+	uint32 NumSubsteps = 0; // Substeps simulated, LOD1 vehicles only trace on every other one
+	int32 FirstKernelLane = 0; // Raycast wheels with a contact are solved in the shared wheel kernel
+	int32 NumKernelLanes = 0;
+	FAVS_WheelKernel WheelKernel; // Used instead of the shared kernel while vehicles are ticked in parallel
+	FAVS_VehicleForces Forces; // Recorded while ticking, applied serially
+	TArray<FAVS_TelemetryRecord> Telemetry; // Recorded while ticking with telemetry enabled, pushed to the ring serially
+	bool bTelemetry = false;
+	const FAVS_SurfaceFrictionTable* SurfaceFrictions = nullptr; // Held by the input of this substep, null without one
+
+	// Physics thread handles of the vehicle body and its physics wheels, only resolved again when the body or a wheel changes
+	Chaos::FRigidBodyHandle_Internal* BodyHandle = nullptr;
+	TArray<Chaos::FRigidBodyHandle_Internal*> WheelHandles; // Indexed by wheel, null for raycast wheels
+	Chaos::FSingleParticlePhysicsProxy* CachedVehicleProxy = nullptr;
+	FAVS_WheelColdBlockPtr CachedColdWheels; // Held so a rebuilt block can never reuse the cached address
+
+	void UpdateHandleCache(const FVehiclePhysicsVehicleInput& VehicleInput);
+
+	// Inputs simulated this substep, replaced by the received frames while the server simulates the vehicle
+	FAVS_Inputs Inputs;
+	uint32 InputFrame = 0; // Last frame simulated
+	uint32 InputFrameEpoch = 0;
+	uint32 LastQueuedInputFrame = 0;
+	TArray<FAVS_InputFrame> PendingInputFrames; // Replay: received frames waiting for a substep, oldest first
+	TArray<FVehiclePhysicsInputRecord> InputRecords; // Frames simulated, oldest first. Predict keeps InputHistorySize of them for replays
+	bool bInputFrameStepped = false; // The last substep simulated a new frame, its record is completed on the next one
+	uint32 CorrectionId = 0;
+	static constexpr int32 MaxOutputInputRecords = 8; // Records sent to the game thread, covers the substeps of a few game frames
+
+	// Picks the inputs of this substep and numbers it, completes the record of the previous frame
+	void StepInputFrame(const FVehiclePhysicsVehicleInput& VehicleInput, float DeltaTime);
+	void WriteInputFrames(FVehiclePhysicsVehicleOutput& VehicleOutput) const;
+
+	// Replays only: moves the body by its recorded forces and gravity without a solver step, body collisions are not simulated
+	void IntegrateBody(float DeltaTime, float GravityZ);
+	void SetBodyState(const FVehiclePhysicsInputRecord& Record);
+
+	// Dormancy with hysteresis, resting is timed between the sleep and wake speeds
+	bool bDormant = false;
+	float RestTime = 0.0f;
+
+	// Puts the body to sleep once it rested long enough and wakes it on contact or input, returns true while the vehicle should be skipped
+	bool UpdateDormancy(const FVehiclePhysicsVehicleInput& VehicleInput, float DeltaTime);
+
+private:
+	void SetBodiesObjectState(Chaos::EObjectStateType ObjectState);
+};
+
+// Vehicle mesh and a mesh it should not collide with, lowest address first so both contact orders find the same pair
+struct FVehicleContactPair
+{
+	const Chaos::FSingleParticlePhysicsProxy* A = nullptr;
+	const Chaos::FSingleParticlePhysicsProxy* B = nullptr;
+
+	FVehicleContactPair(const Chaos::FSingleParticlePhysicsProxy* Proxy1, const Chaos::FSingleParticlePhysicsProxy* Proxy2)
+		: A(Proxy1 < Proxy2 ? Proxy1 : Proxy2), B(Proxy1 < Proxy2 ? Proxy2 : Proxy1) {}
+
+	bool operator==(const FVehicleContactPair& Other) const { return A == Other.A && B == Other.B; }
+	friend uint32 GetTypeHash(const FVehicleContactPair& Pair) { return HashCombineFast(GetTypeHash(Pair.A), GetTypeHash(Pair.B)); }
+};
+
+// Unreal 5.1+ Physics Callback, one per world shared by every vehicle (see UVehicleSimulationSubsystem)
 class FVehiclePhysicsCallback : public Chaos::TSimCallbackObject<FVehiclePhysicsPhysicsInput, FVehiclePhysicsPhysicsOutput, Chaos::ESimCallbackOptions::Presimulate | Chaos::ESimCallbackOptions::ContactModification>
 {
-public:
-	Chaos::FSingleParticlePhysicsProxy* VehicleMesh;
-	TArray<Chaos::FSingleParticlePhysicsProxy*> WheelMeshes;
 private:
+	// ** Physics Thread ** //
+	TArray<FVehiclePhysicsVehicleState> VehicleStates; // Indexed by VehicleId
+	TArray<int32> SimulatedVehicles; // Input indices of the vehicles simulated this substep
+	TArray<int32> DormantVehicles; // Input indices of the vehicles skipped this substep
+	FAVS_WheelQueryBatch WheelQueries; // Wheel rays of every vehicle, resolved together
+	FAVS_WheelKernel WheelKernel; // Raycast wheel tire and suspension math of every vehicle, solved together
+	TSet<FVehicleContactPair> DisabledContacts; // Pairs of every vehicle, each contact pair is looked up once per substep
+	uint32 TelemetrySubstep = 0; // Tags the records of each substep
+
+	// Replays step one vehicle at a time, with their own queries and kernel
+	FAVS_WheelQueryBatch ReplayQueries;
+	FAVS_WheelKernel ReplayKernel;
+	FVehiclePhysicsVehicleOutput ReplayOutput;
+	TArray<FAVS1_Wheel_State> ReplayWheelStates;
+
+	FVehiclePhysicsVehicleState& GetVehicleState(int32 VehicleId, uint32 VehicleSerial);
+
+	// Rewinds a predicting vehicle to the corrected frame and steps it through the recorded frames since, back to the current substep
+	void ReplayCorrection(const UWorld* World, const FVehiclePhysicsVehicleInput& VehicleInput, FVehiclePhysicsVehicleState& VehicleState);
+
+	// Per wheel summary of a simulated vehicle and its recorded telemetry, in input order
+	void PushTelemetry(const FVehiclePhysicsVehicleInput& VehicleInput, FVehiclePhysicsVehicleState& VehicleState, const FVehiclePhysicsVehicleOutput& VehicleOutput);
+
+	// ** Shared ** //
+	TTripleBuffer<FVehiclePhysicsOutputSnapshot> OutputBuffer; // Written by the physics thread, the game thread only reads the latest snapshot
+	FAVS_TelemetryRing TelemetryRing; // Pushed by the physics thread, drained by the game thread while a debug view is open
+
 	virtual void OnPreSimulate_Internal() override;
 	virtual void OnContactModification_Internal(Chaos::FCollisionContactModifier& Modifier) override;
-};
\ No newline at end of file
+
+public:
+	// ** Game Thread ** //
+
+	// Most recent physics step output, null if there was no new step since the last call. Older steps are skipped, not copied
+	const FVehiclePhysicsOutputSnapshot* ConsumeLatestOutput_External();
+
+	// Allocates the telemetry ring, must be called before any input enables telemetry
+	void InitializeTelemetry_External(int32 Capacity);
+
+	// Appends the telemetry records pushed since the last call, returns the number of records lost to overflow
+	int32 DrainTelemetry_External(TArray<FAVS_TelemetryRecord>& OutRecords);
+};
@@ -0,0 +1,56 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VehicleWheelBase.h"
+#include "VehicleSimulationBenchmarkCommandlet.generated.h"
+
+class AVehicleSystemBase;
+
+/**
+ * Headless fixed step vehicle simulation, used for profiling and regression checks.
+ * Spawns vehicles on a flat floor (or a given map), drives them with a scripted input sequence and steps the world at a fixed delta.
+ * Reports physics callback time, world tick time and memory growth, then records or compares the final vehicle transforms.
+ * Golden files keep the settings they were recorded with, the VehicleSystemPlugin.Benchmark.Golden automation test runs each of them again.
+ *
+ * UnrealEditor-Cmd <Project> -run=VehicleSimulationBenchmark -nullrhi -Vehicle=/Game/Vehicles/BP_Car.BP_Car_C
+ *   -Vehicle=        Vehicle class to spawn, required
+ *   -Count=16        Number of vehicles
+ *   -Steps=600       Number of fixed steps
+ *   -Warmup=60       Steps ignored by the timing and memory results
+ *   -Dt=0.0166667    Fixed step delta
+ *   -Torque=600      Drive torque used by the input script
+ *   -Map=/Game/Maps/Test   Optional map to spawn on, for heightfield tests
+ *   -Golden=Default  Name of the golden transforms file in Saved/AVSBenchmark
+ *   -WriteGolden     Record the golden transforms instead of comparing, comparing fails without them
+ *   -Tolerance=1.0   Allowed location (cm) and rotation (degrees) difference
+ */
+UCLASS()
+class UVehicleSimulationBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVehicleSimulationBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	// Runs the benchmark with the commandlet parameters, false on a setup error or a golden mismatch
+	static bool Run(const FString& Params);
+
+	// Saved/AVSBenchmark/<GoldenName>.csv
+	static FString GetGoldenPath(const FString& GoldenName);
+
+	// Parameters the golden transforms were recorded with, empty for files recorded without them
+	static FString LoadGoldenParams(const FString& FilePath);
+
+private:
+	// Deterministic input sequence: accelerate, weave, brake, handbrake
+	static FAVS_Inputs GetScriptedInputs(int32 Step, int32 NumSteps, int32 VehicleIndex, float Torque);
+
+	static bool WriteGolden(const FString& FilePath, const FString& GoldenParams, const TArray<AVehicleSystemBase*>& Vehicles);
+	static bool CompareGolden(const FString& FilePath, const TArray<AVehicleSystemBase*>& Vehicles, float Tolerance);
+};
@@ -0,0 +1,166 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VehiclePhysicsCallback.h"
+#include "VehicleNetRelayComponent.h"
+#include "VehicleTelemetryDashboard.h"
+#include "VehicleSimulationSubsystem.generated.h"
+
+class AGameModeBase;
+
+/**
+ * Per world vehicle simulation manager.
+ * Owns the single physics callback shared by every vehicle so they are marshalled and ticked together on the physics thread.
+ * On the server it also batches the relayed vehicle states per connection.
+ */
+UCLASS()
+class VEHICLESYSTEMPLUGIN_API UVehicleSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+private:
+	FVehiclePhysicsCallback* PhysicsCallback = nullptr;
+
+	// Registered vehicles, indexed by VehicleId
+	TArray<TWeakObjectPtr<AVehicleSystemBase>> Vehicles;
+	TArray<uint32> VehicleSerials;
+	TArray<int32> FreeVehicleIds;
+	uint32 NextVehicleSerial = 1;
+	int32 NumRegisteredVehicles = 0;
+
+	// ** Inputs ** //
+	FVehiclePhysicsPhysicsInput* CurrentInput = nullptr; // Producer input the indices below refer to
+	uint64 CurrentInputFrame = 0;
+	TArray<int32> InputIndices; // Indexed by VehicleId, index into CurrentInput->Vehicles
+
+	// ** Outputs ** //
+	uint64 LastOutputFrame = 0;
+	float ChaosDeltaTime = 0.0f;
+	const FVehiclePhysicsOutputSnapshot* LatestOutput = nullptr; // Read buffer of the physics callback, null if nothing new was received this frame
+	TArray<int32> OutputIndices; // Indexed by VehicleId, index into LatestOutput->Vehicles
+
+	// ** Telemetry ** //
+	static constexpr int32 TelemetryCapacity = 8192; // Records kept by the physics thread between two drains
+	int32 NumTelemetryViewers = 0;
+	bool bRecordSubstepTimes = false;
+	uint64 LastTelemetryFrame = 0;
+	int32 DroppedTelemetryRecords = 0; // Lost to overflow in the last drain
+	TArray<FAVS_TelemetryRecord> TelemetryRecords; // Drained this frame, sorted by VehicleId
+	TArray<FIntPoint> TelemetryRanges; // Indexed by VehicleId, first record and number of records of each vehicle in TelemetryRecords
+	TUniquePtr<FAVS_TelemetryDashboard> TelemetryDashboard; // Only exists while open
+
+	void DrainTelemetry_External();
+
+	// ** Surfaces ** //
+	FAVS_SurfaceFrictionTablePtr SurfaceFrictions; // Shared with the physics thread through every input
+
+	// ** Simulation LOD ** //
+	struct FLODCandidate
+	{
+		AVehicleSystemBase* Vehicle;
+		float ViewerDistance;
+	};
+	TArray<FLODCandidate> LODCandidates;
+
+	// Assigns the simulation LOD of every vehicle by distance to the nearest viewer, within the avs.LOD budgets
+	void UpdateSimulationLODs();
+
+	// ** Network ** //
+	TArray<float> NetSendRates; // Indexed by VehicleId, sends per second each vehicle asked for
+	float TotalNetSendRate = 0.0f;
+
+	struct FPendingNetState
+	{
+		TWeakObjectPtr<AVehicleSystemBase> Vehicle;
+		FNetState State;
+	};
+	TArray<FPendingNetState> PendingNetStates; // Relayed at the end of the frame
+	TMap<FIntPoint, TArray<int32>> RelayCells; // Pending states bucketed by position
+	TArray<FAVS_NetStateRelayEntry> RelayBatch;
+
+	FDelegateHandle PostLoginHandle;
+
+	// Remote controllers get their relay component as they join, so it has replicated by the time states are relayed to them
+	void OnPostLogin(AGameModeBase* GameMode, APlayerController* NewPlayer);
+	static UVehicleNetRelayComponent* AddRelayComponent(APlayerController* PlayerController);
+
+	void RelayNetStates();
+	void SendRelayBatch(UVehicleNetRelayComponent* RelayComponent);
+
+	void CreatePhysicsCallback();
+	void FreePhysicsCallback();
+	void ConsumeOutputs_External();
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UVehicleSimulationSubsystem, STATGROUP_Tickables); }
+
+	// Adds a vehicle to the simulation, returns its VehicleId
+	int32 RegisterVehicle(AVehicleSystemBase* Vehicle);
+	void UnregisterVehicle(int32 VehicleId);
+
+	uint32 GetVehicleSerial(int32 VehicleId) const { return VehicleSerials.IsValidIndex(VehicleId) ? VehicleSerials[VehicleId] : 0; }
+
+	// Registered vehicle, null for free or invalid ids
+	AVehicleSystemBase* GetVehicle(int32 VehicleId) const;
+
+	// Upper bound of the VehicleIds in use
+	int32 GetNumVehicleIds() const { return Vehicles.Num(); }
+
+	// Input slot of the vehicle in this frame's physics thread input
+	FVehiclePhysicsVehicleInput* GetVehicleInput_External(int32 VehicleId);
+
+	// Latest physics thread output of the vehicle, null if nothing new was received this frame
+	const FVehiclePhysicsVehicleOutput* GetVehicleOutput_External(int32 VehicleId);
+
+	// Most recent physics step output of every vehicle, null if nothing new was received this frame
+	const FVehiclePhysicsOutputSnapshot* GetLatestOutput_External() { ConsumeOutputs_External(); return LatestOutput; }
+
+	// Starts a new frame of inputs, outputs and telemetry without GFrameCounter advancing, for tools stepping the world themselves
+	void ResetFrame_External();
+
+	// Makes the friction of a material wheels touched available to the physics thread, from the next input on
+	void AddSurfaceMaterial(const TWeakObjectPtr<UPhysicalMaterial>& PhysMaterial);
+
+	// Tick delta of the chaos physics thread (most recent output)
+	float GetChaosDeltaTime() const { return ChaosDeltaTime; }
+
+	int32 GetNumRegisteredVehicles() const { return NumRegisteredVehicles; }
+
+	// Debug views reading the telemetry register themselves so it is only recorded while someone looks at it
+	void AddTelemetryViewer() { ++NumTelemetryViewers; }
+	void RemoveTelemetryViewer() { NumTelemetryViewers = FMath::Max(NumTelemetryViewers - 1, 0); }
+
+	// True while avs.Debug.Telemetry is set or a viewer is registered, never in Shipping and Test builds
+	bool IsTelemetryEnabled() const;
+
+	// Telemetry records of the vehicle drained this frame, oldest first
+	TArrayView<const FAVS_TelemetryRecord> GetVehicleTelemetry(int32 VehicleId);
+
+	// Telemetry records of every vehicle drained this frame, sorted by VehicleId
+	TArrayView<const FAVS_TelemetryRecord> GetTelemetry() { DrainTelemetry_External(); return TelemetryRecords; }
+
+	// Records the physics thread overwrote before the last drain
+	int32 GetDroppedTelemetryRecords() const { return DroppedTelemetryRecords; }
+
+	// Pushes a Substep telemetry record with the simulate time of every physics substep, for tools timing steps the output skips
+	void SetRecordSubstepTimes(bool bRecord) { bRecordSubstepTimes = bRecord; }
+
+	// Opens or closes the ImGui telemetry window (avs.Debug.Dashboard), Win64 only
+	void ToggleTelemetryDashboard();
+
+	// Server only. Shares the avs.Net.SendBudget states per second between every vehicle
+	void SetNetSendRate(int32 VehicleId, float SendRate);
+
+	// Multiplier for the send rates while their sum is over budget
+	float GetNetSendBudgetScale() const;
+
+	// Server only. Queues a state for the batched relay, false if avs.Net.BatchRelay is disabled and the state should be multicast instead
+	bool QueueNetStateRelay(AVehicleSystemBase* Vehicle, const FNetState& State);
+};
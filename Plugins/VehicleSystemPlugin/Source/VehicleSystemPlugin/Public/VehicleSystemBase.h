@@ -14,6 +14,9 @@
 #include "GameFramework/GameStateBase.h"
 #include "VehicleSystemBase.generated.h"
 
+class UVehicleSimulationSubsystem;
+class UInstancedStaticMeshComponent;
+
 USTRUCT(BlueprintType)
 struct FNetState
 {
@@ -32,6 +35,10 @@ struct FNetState
 	UPROPERTY()
 	FVector angularVelocity;
 
+	// Delta compression, keyframes carry absolute values. Deltas carry the position and timestamp relative to their keyframe
+	uint16 Sequence = 0; // Send sequence of the owner
+	uint16 KeyframeSequence = 0; // Same as Sequence for keyframes
+
 	FNetState()
 	{
 		NetTimestamp = 0.0f;
@@ -41,6 +48,105 @@ struct FNetState
 		velocity = FVector::ZeroVector;
 		angularVelocity = FVector::ZeroVector;
 	}
+
+	bool IsKeyframe() const { return Sequence == KeyframeSequence; }
+
+	// Turns the state into a delta against the keyframe
+	void MakeDelta(const FNetState& Keyframe);
+
+	// Restores the absolute values of a delta, using the keyframe it was made from
+	void ApplyDelta(const FNetState& Keyframe);
+
+	// Quantized: 0.1cm position, smallest three rotation, 1cm/s velocity and 0.1deg/s angular velocity
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FNetState> : public TStructOpsTypeTraitsBase2<FNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+// Received states ordered by timestamp, fixed capacity ring buffer. The client interpolates through it from the front
+struct VEHICLESYSTEMPLUGIN_API FNetStateQueue
+{
+	enum class EInsertResult : uint8
+	{
+		Added, Late, Overflow
+	};
+
+	// Clears the queue
+	void SetCapacity(int32 NewCapacity);
+	int32 GetCapacity() const { return States.Num(); }
+
+	int32 Num() const { return Count; }
+	bool IsEmpty() const { return Count == 0; }
+	void Reset() { Head = 0; Count = 0; }
+
+	// In order states are appended in constant time, out of order states are shifted into place.
+	// LocalTimestamp is only used when the queue is empty, it becomes the point of reference for every following state
+	EInsertResult Insert(const FNetState& State, float LocalTimestamp);
+
+	// Copy of the oldest state with its local timestamp
+	FNetState GetFront() const;
+	void PopFront();
+
+private:
+	TArray<FNetState> States;
+	int32 Head = 0;
+	int32 Count = 0;
+
+	// Local timestamps are calculated when read, offset from the state that started the queue
+	float BaseLocalTimestamp = 0.0f;
+	float BaseNetTimestamp = 0.0f;
+
+	FNetState& At(int32 Index) { return States[(Head + Index) % States.Num()]; }
+	const FNetState& At(int32 Index) const { return States[(Head + Index) % States.Num()]; }
+};
+
+// Client interpolation queue counters, used to tune NetTimeBehind and NetQueueCapacity
+USTRUCT(BlueprintType)
+struct FAVS_JitterBufferStats
+{
+	GENERATED_BODY()
+
+	// States waiting to be synced
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - Network")
+	int32 Depth = 0;
+
+	// Deepest the queue has been
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - Network")
+	int32 MaxDepth = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - Network")
+	int32 Capacity = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - Network")
+	int32 Received = 0;
+
+	// Arrived older than a state that was already synced
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - Network")
+	int32 LateDrops = 0;
+
+	// Arrived while the queue was full
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - Network")
+	int32 OverflowDrops = 0;
+
+	// Distance (cm) of the last correction, from the vehicle to the state it started lerping to or to the server state it reconciled with
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - Network")
+	float NetError = 0.0f;
+};
+
+// Owner prediction history entry, the state is the body state the physics thread ended the frame with
+struct FAVS_PredictedFrame
+{
+	uint32 Frame = 0;
+	FAVS_Inputs Inputs;
+	FNetState State;
+	bool bPredicted = false; // State is only known once the next substep started
 };
 
 UENUM(BlueprintType)
@@ -49,6 +155,12 @@ enum class NetworkRoles : uint8
 	None, Owner, Server, Client, ClientSpawned
 };
 
+UENUM(BlueprintType)
+enum class NetInterpolationType : uint8
+{
+	Linear, Hermite
+};
+
 UENUM(BlueprintType)
 enum class SteeringSmoothingType : uint8
 {
@@ -104,12 +216,25 @@ private:
 
 	// ** Physics Thread ** //
 
-	FVehiclePhysicsCallback* PhysicsThreadCallback;
+	// Per world manager that simulates every vehicle with a single physics callback
+	UPROPERTY()
+	UVehicleSimulationSubsystem* VehicleSimulation = nullptr;
+	int32 VehicleSimulationId = INDEX_NONE;
 
 	UPROPERTY()
 	TArray<UPrimitiveComponent*> ContactModMeshes;
+	TArray<Chaos::FSingleParticlePhysicsProxy*> ContactModProxies;
 
-	TArray<FAVS1_Wheel_State> WheelStates;
+	// Cold wheel data shared with the physics thread, rebuilt when the hash of the simulated wheels changes
+	FAVS_WheelColdBlockPtr WheelColdBlock;
+	uint32 WheelColdHash = 0;
+
+	// ** Wheel Visuals ** //
+
+	// Draws the raycast wheels as instances, one render state update for every wheel
+	UPROPERTY()
+	UInstancedStaticMeshComponent* WheelInstances = nullptr;
+	TArray<FTransform> WheelInstanceTransforms; // Relative to WheelInstances, indexed by instance
 
 protected: // Accessible by subclasses
 
@@ -123,6 +248,7 @@ protected: // Accessible by subclasses
 
 	float TickDeltaTime = 0.0f;
 	void AlwaysTick();
+	void UpdateWheelVisuals(float DeltaTime);
 	void PassiveTick(float DeltaTime);
 	void NetworkTick();
 
@@ -146,6 +272,28 @@ protected: // Accessible by subclasses
 
 	void DetermineLocalRestState();
 
+	// ** Simulation LOD ** //
+
+	// LOD2 state, the vehicle moves without physics at the speed it had when it became kinematic
+	FVector KinematicVelocity = FVector::ZeroVector;
+	FVector KinematicGroundNormal = FVector::UpVector;
+	float KinematicRideHeight = 0.0f; // Distance from the ground to the actor, measured when it became kinematic
+	float KinematicSnapTimer = 0.0f;
+	TArray<FVector> KinematicPath;
+	int32 KinematicPathIndex = 0;
+
+	void KinematicTick(float DeltaTime);
+
+	// Velocity of the body, or the kinematic velocity while in LOD2
+	FVector GetVehicleVelocity() const;
+
+	// Ground below the vehicle for LOD2, false if there is none within reach
+	bool TraceKinematicGround(const FVector& Location, float MaxDistance, FHitResult& OutHit) const;
+
+	// Called whenever the simulation LOD changes
+	UFUNCTION(BlueprintImplementableEvent, Category = "VehicleSystemPlugin")
+	void SimulationLODChanged(EVehicleSimulationLOD NewSimulationLOD);
+
 	// ** Networking ** //
 	#pragma region Networking
 
@@ -178,6 +326,68 @@ protected: // Accessible by subclasses
 	float NetPositionTolerance;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay)
 	float NetSmoothing;
+	// A full keyframe state is sent every this many sends, the sends in between are deltas against it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(ClampMin="1"))
+	int32 NetKeyframeInterval = 10;
+	// Seconds between keyframes at most, so a lost keyframe only drops this long of deltas at low send rates
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(ClampMin="0.01", ClampMax="0.5"))
+	float NetKeyframeMaxInterval = 0.5f;
+	// Received states waiting to be synced, new states are dropped while it is full
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(ClampMin="1"))
+	int32 NetQueueCapacity = 10;
+	// Hermite curves between states using their replicated velocities, which hides gaps with a lower NetTimeBehind
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay)
+	NetInterpolationType NetInterpolation = NetInterpolationType::Linear;
+	// Seconds to keep following the velocity of the last synced state while waiting for the next one, 0 leaves it to local physics
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(ClampMin="0.0"))
+	float NetMaxExtrapolationTime = 0.0f;
+	// Server picks each send interval between NetSendRate and 1 / NetMinSendRate from the vehicle speed, spin and distance to the nearest viewer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay)
+	bool NetAdaptiveSendRate = false;
+	// Sends per second of distant or parked vehicles
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetAdaptiveSendRate", ClampMin="0.1"))
+	float NetMinSendRate = 1.0f;
+	// Viewers at this distance (cm) or further get the minimum send rate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetAdaptiveSendRate", ClampMin="1.0"))
+	float NetRelevancyDistance = 20000.0f;
+	// Speed (cm/s) or angular speed (deg/s) that gets the full send rate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetAdaptiveSendRate", ClampMin="1.0"))
+	float NetMaxRateSpeed = 1500.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetAdaptiveSendRate", ClampMin="1.0"))
+	float NetMaxRateAngularSpeed = 180.0f;
+	// Owner sends early once the last sent state predicts a position this far (cm) from the vehicle
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetAdaptiveSendRate", ClampMin="0.0"))
+	float NetSendErrorTolerance = 25.0f;
+	// Server simulates client owned vehicles from their inputs and corrects the owner, instead of trusting the owner's states
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay)
+	bool NetServerAuthoritative = false;
+	// Owner is corrected once its predicted position is this far (cm) from the server's
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetServerAuthoritative", ClampMin="0.0"))
+	float NetReconcileTolerance = 10.0f;
+	// Frames of inputs and predicted states kept by the owner, has to cover the round trip time
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetServerAuthoritative", ClampMin="1"))
+	int32 NetInputHistorySize = 128;
+	// Largest drive torque (Nm) the server accepts from the owner's inputs, 0 doesn't limit it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetServerAuthoritative", ClampMin="0.0"))
+	float NetMaxInputTorque = 20000.0f;
+	// Server rejects client states that aren't physically reachable from the last accepted one, and corrects the owner
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay)
+	bool NetValidateMovement = false;
+	// Largest velocity change (cm/s^2) accepted between two states
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetValidateMovement", ClampMin="0.0"))
+	float NetMaxAcceleration = 20000.0f;
+	// Largest distance (cm) a state may be from where the last accepted state predicts it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetValidateMovement", ClampMin="0.0"))
+	float NetMaxTeleportDistance = 500.0f;
+	// Converts the Gears speeds to cm/s (default is km/h), the top gear EndSpeed times NetSpeedTolerance is the max accepted speed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetValidateMovement", ClampMin="0.0"))
+	float GearSpeedToCmPerSecond = 27.7778f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetValidateMovement", ClampMin="1.0"))
+	float NetSpeedTolerance = 1.5f;
+	// Most server time (s) one client state can account for, the bounds are measured with server time so client timestamps can't widen them.
+	// Raised to 1.5 send intervals when the adaptive send rate sends less often
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Network", AdvancedDisplay, meta=(EditCondition="NetValidateMovement", ClampMin="0.01"))
+	float NetMaxValidationDeltaTime = 0.5f;
 
 	UPROPERTY(ReplicatedUsing=OnRep_RestState)
 	FNetState RestState;
@@ -205,10 +415,97 @@ protected: // Accessible by subclasses
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "VehicleSystemPlugin")
 	void WakeWheelsForMovement();
 
-	TArray<FNetState> StateQueue;
+	// Delta compression
+	uint16 NetSendSequence = 0;
+	FNetState LastSentKeyframe;
+	bool SendKeyframe = true;
+	TArray<FNetState, TInlineAllocator<4>> ReceivedKeyframes; // Most recent keyframes of the owner, deltas without one are dropped
+
+	// Makes a received state absolute, false if its keyframe was never received
+	bool ResolveNetState(FNetState& State) { return ResolveNetState(State, ReceivedKeyframes); }
+	static bool ResolveNetState(FNetState& State, TArray<FNetState, TInlineAllocator<4>>& Keyframes);
+
+	// Applies the keyframe of a delta state without storing keyframes, false if its keyframe is unknown
+	static bool ApplyNetStateKeyframe(FNetState& State, const TArray<FNetState, TInlineAllocator<4>>& Keyframes);
+	static constexpr float MaxNetKeyframeAge = 1.0f; // Seconds, twice the largest NetKeyframeMaxInterval. Older deltas refer to a keyframe with a wrapped sequence
+	static void AddNetStateKeyframe(const FNetState& Keyframe, TArray<FNetState, TInlineAllocator<4>>& Keyframes);
+
+	// Movement validation, server only
+	TArray<FNetState, TInlineAllocator<4>> ValidationKeyframes; // Only keyframes that passed validation
+	FNetState LastAcceptedState;
+	bool HasAcceptedState = false;
+	float LastValidationTime = 0.0f; // Server time the validation time budget was last refilled
+	float ValidationTimeBudget = 0.0f; // Server time not yet accounted for by accepted states, capped at GetMaxValidationDeltaTime
+	float LastCorrectionTime = -1.0f;
+	int32 NetValidationViolations = 0;
+
+	// Constant time plausibility checks against the last accepted state, no scene queries
+	bool ValidateNetState(const FNetState& State);
+
+	// First state of an owner, checked against the server's body as if it was the last accepted state
+	bool IsReachableFromServerBody(const FNetState& State) const;
+	void RejectNetState();
+
+	// Top gear speed (cm/s), read from Gears every time so runtime changes apply
+	float GetMaxGearSpeed() const;
+
+	// Server time a client state that advanced its timestamp by ClientDeltaTime may account for, refills the budget with the server time since the last state
+	float ConsumeValidationTime(float ClientDeltaTime);
+	float GetMaxValidationDeltaTime() const { return FMath::Max3(NetMaxValidationDeltaTime, NetSendInterval * 1.5f, 0.01f); }
+
+	// Called on the server every time a client state is rejected
+	UFUNCTION(BlueprintImplementableEvent, Category = "VehicleSystemPlugin")
+	void NetStateRejected(int32 Violations);
+
+	// Adaptive send rate, decided by the server and replicated to the owner. 0 sends at NetSendRate
+	UPROPERTY(Replicated)
+	float NetSendInterval = 0.0f;
+	FNetState LastSentState;
+
+	// Prediction, only used with NetServerAuthoritative
+	// Frames are physics substeps numbered by the owner's physics thread, the server simulates every received frame on one substep
+	uint32 InputFrame = 0; // Owner: newest frame recorded from the physics thread
+	TArray<FAVS_PredictedFrame> PredictionHistory; // Owner: indexed by Frame % NetInputHistorySize
+	TArray<FAVS_InputFrame> ServerInputQueue; // Server: received frames the physics thread hasn't queued yet
+	uint32 LastReceivedInputFrame = 0;
+	uint32 LastProcessedInputFrame = 0; // Server: newest frame simulated
+	FNetState LastProcessedState; // Server: body state at the end of LastProcessedInputFrame
+	uint32 InputFrameEpoch = 0; // Changes whenever frames restart, the physics thread then drops the frames it queued
+	FVehiclePhysicsInputRecord PendingCorrection; // Owner: server state the physics thread replays the later frames from
+	uint32 CorrectionId = 0; // Owner: incremented for every correction sent to the physics thread
+	uint32 AppliedCorrectionId = 0; // Owner: last correction the physics thread replayed
+
+	// Server simulates this client owned vehicle from the received inputs
+	bool IsServerSimulated() { return NetServerAuthoritative && GetNetworkRole() == NetworkRoles::Server; }
+	// Owning client predicts and is corrected by the server
+	bool IsPredictingOwner() { return NetServerAuthoritative && GetNetworkRole() == NetworkRoles::Owner && !isServer(); }
+	// Sends the movement states everyone else syncs to
+	bool IsNetStateSender() { return IsServerSimulated() || (GetNetworkRole() == NetworkRoles::Owner && !IsPredictingOwner()); }
+
+	void SetPhysicsInputFrames(FVehiclePhysicsVehicleInput& PhysicsInput);
+	void RecordPredictedFrames(const FVehiclePhysicsVehicleOutput& PhysicsOutput);
+	void ConsumeServerFrames(const FVehiclePhysicsVehicleOutput& PhysicsOutput);
+	void ResetPrediction();
+	// Clamps inputs received from the owner to what a local player could send
+	FAVS_Inputs SanitizeServerInputs(const FAVS_Inputs& Inputs) const;
+
+	// Server side of the state RPCs, also called directly when the server sends its own states
+	void RelayNetState(const FNetState& State);
+	void StoreRestState(const FNetState& State);
+	void SendNetState(const FNetState& State);
+	void SendRestState(const FNetState& State);
+
+	bool ShouldSendNetState(const FNetState& State) const;
+	void UpdateNetSendInterval(const FNetState& State);
+	float GetNearestViewerDistance() const;
+
+	FNetStateQueue StateQueue;
+	FAVS_JitterBufferStats JitterBufferStats;
 	FNetState LerpStartState;
 	bool CreateNewStartState = true;
 	float LastActiveTimestamp = 0;
+	FNetState LastSyncedState; // Extrapolated from until the next state is due
+	bool CanExtrapolate = false;
 
 	FTimerHandle NetSendTimer;
 	UFUNCTION()
@@ -222,9 +519,10 @@ protected: // Accessible by subclasses
 	FNetState CreateNetStateForNow();
 	void AddStateToQueue(FNetState StateToAdd);
 	void ClearQueue();
-	void CalculateTimestamps();
 	void SyncPhysics();
 	void LerpToNetState(FNetState NextState, float CurrentServerTime);
+	void InterpolateNetState(const FNetState& From, const FNetState& To, float Alpha, float Duration, FVector& OutPosition, FRotator& OutRotation) const;
+	bool ExtrapolateNetState(float CurrentTime);
 	void ApplyExactNetState(FNetState State);
 
 	bool isServer()
@@ -274,6 +572,16 @@ protected: // Accessible by subclasses
 	void Client_ReceiveNetState(FNetState State);
 	virtual bool Client_ReceiveNetState_Validate(FNetState State);
 	virtual void Client_ReceiveNetState_Implementation(FNetState State);
+	UFUNCTION(Server, unreliable, WithValidation)
+	void Server_ReceiveInputs(const TArray<FAVS_InputFrame>& Inputs);
+	virtual bool Server_ReceiveInputs_Validate(const TArray<FAVS_InputFrame>& Inputs);
+	virtual void Server_ReceiveInputs_Implementation(const TArray<FAVS_InputFrame>& Inputs);
+	UFUNCTION(Client, unreliable)
+	void Client_ReceiveCorrection(FNetState State, uint32 Frame);
+	virtual void Client_ReceiveCorrection_Implementation(FNetState State, uint32 Frame);
+	UFUNCTION(Client, reliable)
+	void Client_CorrectNetState(FNetState State);
+	virtual void Client_CorrectNetState_Implementation(FNetState State);
 	UFUNCTION(Server, reliable, WithValidation)
 	void Server_ReceiveRestState(FNetState State);
 	virtual bool Server_ReceiveRestState_Validate(FNetState State);
@@ -293,6 +601,10 @@ protected: // Accessible by subclasses
 	UFUNCTION(BlueprintCallable, Category = "VehicleSystemPlugin")
 	void UpdateInternalWheelArray();
 
+	// Draws every raycast wheel as an instance of this component instead of its own wheel mesh, the instanced mesh should match the wheel meshes. Null restores the wheel meshes
+	UFUNCTION(BlueprintCallable, Category = "VehicleSystemPlugin")
+	void SetWheelInstances(UInstancedStaticMeshComponent* NewWheelInstances);
+
 	// Register async callback with physics system.
 	bool IsPhysicsCallbackRegistered();
 	void RegisterPhysicsCallback();
@@ -314,28 +626,51 @@ protected: // Accessible by subclasses
 		InputsForPhysicsThread = NewInputs;
 	}
 
+	// Any input wakes a dormant vehicle, steering and brakes change its wheels even while it is parked
+	bool HasDormancyWakeInput() const;
+
 	// ** Debug ** //
 
+	// Latest wheel traces, only filled while telemetry is enabled (avs.Debug.Telemetry)
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "VehicleSystemPlugin")
 	TArray<FHitResult> DebugTraces;
 
+	// Latest wheel forces, only filled while telemetry is enabled (avs.Debug.Telemetry)
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "VehicleSystemPlugin")
 	TArray<FDebugForce> DebugForces;
 
-	static void AddDebugTrace(FVehiclePhysicsPhysicsOutput& PhysicsOutput, const FHitResult& Trace)
+	// Telemetry is staged in the vehicle state and pushed to the ring after the vehicles ticked
+	static void AddTelemetryTrace(FVehiclePhysicsVehicleState& PhysicsState, int32 WIndex, const FHitResult& Trace, EWheelMode WheelMode)
 	{
-		#if !UE_BUILD_SHIPPING && !UE_BUILD_TEST
-		PhysicsOutput.DebugTraces.Add(Trace);
+		#if AVS_TELEMETRY
+		if( !PhysicsState.bTelemetry ) return;
+		FAVS_TelemetryRecord& Record = PhysicsState.Telemetry.AddDefaulted_GetRef();
+		Record.Type = EAVS_TelemetryType::Trace;
+		Record.WheelMode = WheelMode;
+		Record.bContact = Trace.bBlockingHit;
+		Record.WheelIndex = static_cast<int16>(WIndex);
+		Record.Start = Trace.TraceStart;
+		Record.End = Trace.TraceEnd;
+		Record.Point = Trace.ImpactPoint;
 		#endif
 	}
 
-	static void AddDebugForce(FVehiclePhysicsPhysicsOutput& PhysicsOutput, const FDebugForce& Force)
+	static void AddTelemetryForce(FVehiclePhysicsVehicleState& PhysicsState, int32 WIndex, const FVector& Location, const FVector& Force, EWheelMode WheelMode)
 	{
-		#if !UE_BUILD_SHIPPING && !UE_BUILD_TEST
-		PhysicsOutput.DebugForces.Add(Force);
+		#if AVS_TELEMETRY
+		if( !PhysicsState.bTelemetry ) return;
+		FAVS_TelemetryRecord& Record = PhysicsState.Telemetry.AddDefaulted_GetRef();
+		Record.Type = EAVS_TelemetryType::Force;
+		Record.WheelMode = WheelMode;
+		Record.WheelIndex = static_cast<int16>(WIndex);
+		Record.Start = Location;
+		Record.End = Force;
 		#endif
 	}
 
+	// Rebuilds DebugTraces and DebugForces from the telemetry drained this frame
+	void UpdateDebugTelemetry();
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void BlueprintDebugMessage(const FString& text);
 
@@ -360,7 +695,22 @@ public:
 
 	// ** Physics Thread ** //
 
-	void AVS_PhysicsTick(float ChaosDelta, const FVehiclePhysicsPhysicsInput* PhysicsInput, FVehiclePhysicsPhysicsOutput& PhysicsOutput);
+	// Calculates the wheel transforms and adds the wheel rays to the shared query batch
+	static void AVS_GatherWheelQueries(const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState, FAVS_WheelQueryBatch& WheelQueries);
+
+	// Simulates the wheels of a single vehicle once its wheel queries are resolved, raycast wheels with a contact are added to the wheel kernel.
+	// Only touches this vehicle's state and output, forces are recorded in PhysicsState.Forces
+	static void AVS_PhysicsTick(float ChaosDelta, const UWorld* World, const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState,
+		const FAVS_WheelQueryBatch& WheelQueries, FAVS_WheelKernel& WheelKernel, FVehiclePhysicsVehicleOutput& PhysicsOutput);
+
+	// Applies the solved wheel kernel lanes of a single vehicle
+	static void AVS_ApplyWheelKernel(const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState, const FAVS_WheelKernel& WheelKernel,
+		FVehiclePhysicsVehicleOutput& PhysicsOutput);
+
+	// Gathers, traces and solves the wheels of a single vehicle on its own batches, used to replay input frames.
+	// Forces are recorded in PhysicsState.Forces like a normal tick
+	static void AVS_StepVehicle(float ChaosDelta, const UWorld* World, const FVehiclePhysicsVehicleInput& PhysicsInput, FVehiclePhysicsVehicleState& PhysicsState,
+		FAVS_WheelQueryBatch& WheelQueries, FAVS_WheelKernel& WheelKernel, FVehiclePhysicsVehicleOutput& PhysicsOutput);
 
 	// ** Passive / Rest ** //
 
@@ -373,7 +723,7 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - General", AdvancedDisplay)
 	bool PassiveTickGatekeeping = true;
 
-	// Velocity (cm) at which the vehicle is considered moving, used for network rest state and passive mode
+	// Velocity (cm) at which the vehicle is considered moving, used for network rest state, passive mode and dormancy
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay)
 	float RestVelocityThreshold = 25.0f;
 
@@ -381,6 +731,103 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - General")
 	bool LocalVehicleAtRest = false;
 
+	// Put the vehicle to sleep on the physics thread once it rested for DormancyDelay, dormant vehicles skip their wheel traces and forces until woken by a contact or drive input
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay)
+	bool PhysicsDormancy = false;
+
+	// Seconds the vehicle has to stay below RestVelocityThreshold and DormancyRestAngularVelocity before going dormant
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="PhysicsDormancy", ClampMin="0.0"))
+	float DormancyDelay = 2.0f;
+
+	// Velocity (cm/s) above which the dormancy timer restarts, between it and RestVelocityThreshold the timer is held
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="PhysicsDormancy", ClampMin="0.0"))
+	float DormancyWakeVelocity = 50.0f;
+
+	// Angular velocity (deg/s) the vehicle has to stay below to go dormant
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="PhysicsDormancy", ClampMin="0.0"))
+	float DormancyRestAngularVelocity = 5.0f;
+
+	// Angular velocity (deg/s) above which the dormancy timer restarts
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="PhysicsDormancy", ClampMin="0.0"))
+	float DormancyWakeAngularVelocity = 10.0f;
+
+	// Vehicle is dormant on the physics thread, no inputs are sent while its body sleeps
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - General")
+	bool PhysicsDormant = false;
+
+	// ** Simulation LOD ** //
+
+	// Lower the simulation fidelity with the distance to the nearest viewer, within the avs.LOD budgets (see UVehicleSimulationSubsystem)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay)
+	bool UseSimulationLOD = false;
+
+	// Distance (cm) to the nearest viewer at which the vehicle switches to LOD1
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="UseSimulationLOD", ClampMin="0.0"))
+	float SimulationLOD1Distance = 5000.0f;
+
+	// Distance (cm) to the nearest viewer at which the vehicle becomes kinematic (LOD2), only on the authority and without physics wheels
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="UseSimulationLOD", ClampMin="0.0"))
+	float SimulationLOD2Distance = 15000.0f;
+
+	// Distance (cm) the viewer has to come closer than a LOD distance before the vehicle switches back, prevents switching back and forth
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="UseSimulationLOD", ClampMin="0.0"))
+	float SimulationLODHysteresis = 1000.0f;
+
+	// Seconds between ground traces while kinematic (LOD2)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="UseSimulationLOD", ClampMin="0.0"))
+	float KinematicGroundSnapInterval = 0.5f;
+
+	// Current simulation fidelity
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle - General")
+	EVehicleSimulationLOD SimulationLOD = EVehicleSimulationLOD::LOD0;
+
+	// Distance used to choose the LOD, zero for player controlled vehicles so they always get the full simulation
+	float GetSimulationLODDistance() const;
+
+	// LOD for the given viewer distance, with hysteresis towards the current LOD
+	EVehicleSimulationLOD GetDesiredSimulationLOD(float ViewerDistance) const;
+
+	// LOD2 needs authority over the movement and a ground to snap to, physics wheels can't follow a kinematic body
+	bool CanSimulateKinematic() const;
+
+	// Switches the simulation fidelity, kinematic is only entered when the ground below the vehicle is found
+	UFUNCTION(BlueprintCallable, Category = "VehicleSystemPlugin")
+	void SetSimulationLOD(EVehicleSimulationLOD NewSimulationLOD);
+
+	// World locations followed while kinematic (LOD2), without a path the vehicle keeps its heading
+	UFUNCTION(BlueprintCallable, Category = "VehicleSystemPlugin")
+	void SetKinematicPath(const TArray<FVector>& PathPoints)
+	{
+		KinematicPath = PathPoints;
+		KinematicPathIndex = 0;
+	}
+
+	// Reuse the last wheel contacts on static ground instead of tracing again while moving slower than RestVelocityThreshold
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay)
+	bool UseContactCache = true;
+
+	// Distance (cm) a wheel ray can move before the cached contact is traced again
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Vehicle - Physics", AdvancedDisplay, meta=(EditCondition="UseContactCache", ClampMin="0.0"))
+	float ContactCacheTolerance = 0.5f;
+
+	// ** Networking ** //
+
+	// Counters of the client state queue, depth is the current number of queued states
+	UFUNCTION(BlueprintPure, Category = "VehicleSystemPlugin")
+	FAVS_JitterBufferStats GetJitterBufferStats() const
+	{
+		FAVS_JitterBufferStats Stats = JitterBufferStats;
+		Stats.Depth = StateQueue.Num();
+		Stats.Capacity = StateQueue.GetCapacity();
+		return Stats;
+	}
+
+	UFUNCTION(BlueprintCallable, Category = "VehicleSystemPlugin")
+	void ResetJitterBufferStats() { JitterBufferStats = FAVS_JitterBufferStats(); }
+
+	// Resolves a state relayed by the server and queues it for syncing
+	void ReceiveNetState(FNetState State);
+
 	// ** Config ** //
 
 	/** Max steering input based on the vehicle speed */
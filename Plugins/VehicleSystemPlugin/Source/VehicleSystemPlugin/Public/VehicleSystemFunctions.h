@@ -7,6 +7,11 @@
 #include "Runtime/Core/Public/Misc/EngineVersion.h"
 #include "VehicleSystemFunctions.generated.h"
 
+namespace Chaos
+{
+	class FRigidBodyHandle_Internal;
+}
+
 /* 
 *	Function library class.
 *	Each function in it is expected to be static and represents blueprint node that can be called in any blueprint.
@@ -133,4 +138,17 @@ class UVehicleSystemFunctions : public UBlueprintFunctionLibrary
 	/** For use on the chaos physics thread only */
 	UFUNCTION(BlueprintCallable, Category = "VehicleSystemPlugin - Chaos Functions")
 	static FVector AVS_ChaosGetVelocityAtLocation(UPrimitiveComponent* Component, FVector Location);
+
+	// ** Physics thread handle overloads, no game thread objects are touched ** //
+
+	// Physics thread handle of the component's body, null without one. Resolve once and use the overloads below
+	static Chaos::FRigidBodyHandle_Internal* GetRigidHandle(const UPrimitiveComponent* target);
+
+	static FTransform AVS_GetChaosTransform(const Chaos::FRigidBodyHandle_Internal* RigidHandle);
+	static void AVS_ChaosAddForce(Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Force, bool bAccelChange);
+	static void AVS_ChaosAddForceAtLocation(Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Location, FVector Force);
+	static FVector AVS_ChaosGetCenterOfMass(const Chaos::FRigidBodyHandle_Internal* RigidHandle);
+	static void AVS_ChaosAddAccumulatedForce(Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Force, FVector Torque); // Summed force at the center of mass and its torque in one write
+	static void AVS_ChaosBrakes(Chaos::FRigidBodyHandle_Internal* RigidHandle, float BrakeTorque, float ChaosDelta);
+	static FVector AVS_ChaosGetVelocityAtLocation(const Chaos::FRigidBodyHandle_Internal* RigidHandle, FVector Location);
 };
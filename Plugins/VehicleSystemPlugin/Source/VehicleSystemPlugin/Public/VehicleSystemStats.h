@@ -0,0 +1,52 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+// ** Profiling ** //
+// Timings: "stat AVS", and Unreal Insights with the AVS trace channel ("-trace=cpu,AVS" or "Trace.Enable AVS" at runtime)
+// Counters: "stat AVS" and the AVS CSV category ("-csvCategories=AVS" or "CsvCategory AVS"), only recorded while avs.Stats is set
+
+DECLARE_STATS_GROUP(TEXT("Vehicle System"), STATGROUP_AVS, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics PreSimulate"), STAT_AVS_PreSimulate, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Wheel Traces"), STAT_AVS_WheelTraces, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Tick"), STAT_AVS_PhysicsTick, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Apply Forces"), STAT_AVS_ApplyForces, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Contact Modification"), STAT_AVS_ContactModification, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Replay"), STAT_AVS_Replay, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Always Tick"), STAT_AVS_AlwaysTick, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sync Physics"), STAT_AVS_SyncPhysics, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Net State Send"), STAT_AVS_NetStateSend, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wheel Visuals"), STAT_AVS_WheelVisuals, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Simulation Subsystem"), STAT_AVS_Subsystem, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Vehicles Simulated"), STAT_AVS_VehiclesSimulated, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wheels Simulated"), STAT_AVS_WheelsSimulated, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wheel Traces"), STAT_AVS_Traces, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Forces Applied"), STAT_AVS_ForcesApplied, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Queue Depth"), STAT_AVS_QueueDepth, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Bytes Sent"), STAT_AVS_BytesSent, STATGROUP_AVS, VEHICLESYSTEMPLUGIN_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(VEHICLESYSTEMPLUGIN_API, AVS);
+UE_TRACE_CHANNEL_EXTERN(AVSChannel, VEHICLESYSTEMPLUGIN_API);
+
+namespace AVSStats
+{
+	// avs.Stats, counters cost nothing while it is off
+	VEHICLESYSTEMPLUGIN_API bool IsEnabled();
+}
+
+// Scope timed in the stat group and on the AVS trace channel
+#define AVS_SCOPE_CYCLE_COUNTER(Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, AVSChannel); \
+	SCOPE_CYCLE_COUNTER(Stat)
+
+// Adds to a counter of the stat group and to the CSV stat of the same name, summed over the frame
+#define AVS_COUNTER_ADD(Counter, Value) \
+	do { if( AVSStats::IsEnabled() ) { const int32 AVSCounterValue = (Value); INC_DWORD_STAT_BY(STAT_AVS_##Counter, AVSCounterValue); CSV_CUSTOM_STAT(AVS, Counter, AVSCounterValue, ECsvCustomStatOp::Accumulate); } } while( 0 )
@@ -0,0 +1,66 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VehicleWheelBase.h"
+#include <atomic>
+
+// Physics telemetry is only recorded outside of Shipping and Test builds
+#define AVS_TELEMETRY (!UE_BUILD_SHIPPING && !UE_BUILD_TEST)
+
+enum class EAVS_TelemetryType : uint8
+{
+	Trace, // Start: ray start, End: ray end, Point: contact point
+	Force, // Start: location, End: force (cN)
+	Wheel, // Slip, spring length, angular velocity and drive torque after the substep
+	Substep, // SimulateMs of every vehicle in the substep, VehicleId is INDEX_NONE
+};
+
+// Plain telemetry record, copied through the ring as is
+struct FAVS_TelemetryRecord
+{
+	EAVS_TelemetryType Type = EAVS_TelemetryType::Trace;
+	EWheelMode WheelMode = EWheelMode::Raycast;
+	bool bContact = false;
+	int16 WheelIndex = INDEX_NONE;
+	int32 VehicleId = INDEX_NONE;
+	uint32 Substep = 0;
+
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FVector Point = FVector::ZeroVector;
+
+	FVector2f Slip = FVector2f::ZeroVector;
+	float SpringLength = 0.0f; // cm
+	float AngularVelocity = 0.0f; // rad/s
+	float DriveTorque = 0.0f; // Nm
+	float SimulateMs = 0.0f;
+};
+static_assert(std::is_trivially_copyable_v<FAVS_TelemetryRecord>, "Telemetry records are copied through the ring without construction");
+
+/**
+ * Fixed size single producer / single consumer ring of telemetry records.
+ * The physics thread pushes without locks or allocations, when the game thread falls behind the oldest records are overwritten.
+ * Records the producer overwrote while the consumer was copying them are detected afterwards and dropped.
+ */
+class VEHICLESYSTEMPLUGIN_API FAVS_TelemetryRing
+{
+public:
+	// Game thread, before the producer is allowed to push. Capacity is rounded up to a power of two
+	void Initialize(int32 InCapacity);
+	bool IsInitialized() const { return Records.Num() > 0; }
+
+	// Producer only
+	void Push(const FAVS_TelemetryRecord& Record);
+
+	// Consumer only. Appends every record pushed since the last drain, returns the number of records lost to overflow
+	int32 Drain(TArray<FAVS_TelemetryRecord>& OutRecords);
+
+private:
+	TArray<FAVS_TelemetryRecord> Records;
+	uint64 Mask = 0;
+	std::atomic<uint64> Head { 0 }; // Next record written, only advanced by the producer
+	uint64 Tail = 0; // Next record read, consumer only
+};
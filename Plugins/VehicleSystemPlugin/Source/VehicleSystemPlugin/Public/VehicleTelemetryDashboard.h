@@ -0,0 +1,73 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UVehicleSimulationSubsystem;
+class FRMAImGuiHook;
+
+/**
+ * ImGui window plotting the telemetry of one vehicle (avs.Debug.Dashboard), only available where RMAImGui is (Win64).
+ * Only exists while open: it registers itself as a telemetry viewer and samples once per frame into a fixed size history.
+ */
+class VEHICLESYSTEMPLUGIN_API FAVS_TelemetryDashboard
+{
+public:
+	FAVS_TelemetryDashboard(UVehicleSimulationSubsystem* InSimulation);
+	~FAVS_TelemetryDashboard();
+
+	// False once the window was closed, the subsystem then destroys the dashboard
+	bool IsOpen() const { return bOpen; }
+
+	// Game thread, once per frame after the vehicles ticked
+	void Sample(float DeltaTime);
+
+private:
+	// Plotted per vehicle
+	enum EVehicleChannel
+	{
+		ChaosDeltaTime, // ms
+		QueueDepth,
+		NetError, // cm
+		NumVehicleChannels
+	};
+
+	// Plotted per wheel
+	enum EWheelChannel
+	{
+		SlipX,
+		SlipY,
+		SpringLength, // cm
+		AngularVelocity, // rad/s
+		Force, // N, sum of the forces the wheel applied
+		NumWheelChannels
+	};
+
+	TWeakObjectPtr<UVehicleSimulationSubsystem> Simulation;
+	FRMAImGuiHook* Hook = nullptr; // Owned, the ImGui context only keeps a pointer
+	bool bOpen = true;
+
+	// Selected vehicle, the history restarts when it changes
+	int32 VehicleId = INDEX_NONE;
+	uint32 VehicleSerial = 0;
+	int32 NumWheels = 0;
+
+	// History shared by every channel, oldest samples are overwritten
+	int32 Capacity = 0;
+	int32 NumSamples = 0;
+	int32 NextSample = 0;
+	float Time = 0.0f;
+	TArray<float> Times;
+	TArray<float> Values; // Channel major, Capacity samples per channel
+	float PlotWindow = 10.0f; // Seconds shown, older samples are kept but not drawn
+
+	int32 GetNumChannels() const { return NumVehicleChannels + NumWheels * NumWheelChannels; }
+	float* GetChannel(int32 Channel) { return Values.GetData() + Channel * Capacity; }
+	void SelectVehicle(int32 InVehicleId, int32 InNumWheels);
+
+	// ImGui hook, the subsystem and vehicles are only read
+	void Draw();
+	void DrawChannel(const char* Label, int32 Channel, int32 FirstSample, int32 Count);
+};
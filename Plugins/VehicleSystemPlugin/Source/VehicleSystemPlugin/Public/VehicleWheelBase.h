@@ -5,15 +5,27 @@
 
 #include "CoreMinimal.h"
 #include "Engine/HitResult.h"
+#include "Chaos/ChaosEngineInterface.h"
 #include "Components/SceneComponent.h"
 #include "VehicleWheelBase.generated.h"
 
+class UPhysicalMaterial;
+
 UENUM(BlueprintType)
 enum class EWheelMode : uint8
 {
 	Raycast, Physics
 };
 
+// Simulation fidelity of a vehicle, chosen by distance to the nearest viewer (see UVehicleSimulationSubsystem)
+UENUM(BlueprintType)
+enum class EVehicleSimulationLOD : uint8
+{
+	LOD0, // Full tire model, wheels traced every substep
+	LOD1, // Simplified friction, wheels traced every other substep
+	LOD2 // Kinematic, follows its path with occasional ground snapping
+};
+
 USTRUCT(BlueprintType)
 struct FDebugForce
 {
@@ -57,6 +69,18 @@ struct FAVS_Inputs // Input data to sent to physics thread each game tick
 	FAVS_Inputs(){}
 };
 
+// Inputs of one owner frame, sent to the server while it simulates the vehicle
+USTRUCT()
+struct FAVS_InputFrame
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint32 Frame = 0;
+	UPROPERTY()
+	FAVS_Inputs Inputs;
+};
+
 USTRUCT()
 struct FAVS1_Wheel_State // Physics thread wheel state
 {
@@ -68,15 +92,54 @@ struct FAVS1_Wheel_State // Physics thread wheel state
 	FAVS1_Wheel_State(){}
 };
 
+USTRUCT(BlueprintType)
+struct FAVS_WheelContact // Compact wheel contact, the full FHitResult is only rebuilt on demand
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
+	bool bBlockingHit = false;
+
+	// Distance (cm) from the top of the wheel ray
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
+	float Distance = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
+	FVector ImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
+	FVector ImpactNormal = FVector::UpVector;
+
+	// Resolved from the physical material on the game thread (see ResolveSurfaceType)
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
+	TEnumAsByte<EPhysicalSurface> SurfaceType = SurfaceType_Default;
+
+	// Contacted body
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
+	TWeakObjectPtr<UPhysicalMaterial> PhysMaterial;
+
+	FAVS_WheelContact(){}
+	explicit FAVS_WheelContact(const FHitResult& Hit); // Physics thread safe, weak pointers are copied and not resolved
+
+	// Game thread only
+	void ResolveSurfaceType();
+
+	// Hit result with the stored fields, the trace ray is not kept
+	FHitResult ToHitResult() const;
+};
+
 USTRUCT(BlueprintType)
 struct FAVS1_Wheel_Output // Data output from the physics thread
 {
 	GENERATED_BODY()
 
-	// Last trace
+	// Last wheel contact
 	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
-	FHitResult LastTrace;
-	
+	FAVS_WheelContact Contact;
+
 	// Wheel's angular velocity in Rad/s
 	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
 	float AngularVelocity = 0.0f;
@@ -202,6 +265,15 @@ class VEHICLESYSTEMPLUGIN_API UVehicleWheelBase : public USceneComponent
 private:
 	float CurAngVel = 0.0f;
 
+	// Last visual transform written for the wheel mesh, unchanged wheels are skipped
+	FVector LastVisualLocation = FVector::ZeroVector;
+	FQuat LastVisualRotation = FQuat::Identity;
+	bool HasVisualTransform = false;
+
+	// Built from WheelData.Contact when Blueprint asks for it (see GetLastTrace)
+	mutable FHitResult LastTrace;
+	mutable bool bLastTraceDirty = true;
+
 protected: // Accessible by subclasses
 	virtual void BeginPlay() override;
 
@@ -232,7 +304,17 @@ protected: // Accessible by subclasses
 	
 public:	
 	UVehicleWheelBase();
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// ** Visuals ** //
+
+	// Spins and places the raycast wheel mesh, called by the vehicle for every wheel at once. False if the transform relative to this wheel did not change enough to be written
+	bool UpdateVisual(float DeltaTime, FTransform& OutRelativeTransform);
+
+	// Forces the next visual update to be written
+	void ResetVisual() { HasVisualTransform = false; }
+
+	// Instance of the vehicle's wheel instancer drawing this wheel, INDEX_NONE when the wheel mesh is drawn
+	int32 VisualInstanceIndex = INDEX_NONE;
 
 	// ** Config ** //
 
@@ -269,6 +351,9 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "Vehicle System Plugin|Wheel State")
 	FAVS1_Wheel_Output WheelData;
 
+	// Call when WheelData changes, the hit result is rebuilt the next time it is asked for
+	void MarkLastTraceDirty() { bLastTraceDirty = true; }
+
 	UPROPERTY()
 	FRotator WheelRotation;
 
@@ -303,7 +388,19 @@ public:
 	void ResetWheelCollisions();
 
 	UFUNCTION(BlueprintPure, Category = "Vehicle System Plugin|Wheel State")
-	bool GetHasContact() { return WheelData.LastTrace.bBlockingHit; }
+	bool GetHasContact() { return WheelData.Contact.bBlockingHit; }
+
+	// Last wheel contact as a hit result, rebuilt from the compact contact after it changed
+	UFUNCTION(BlueprintPure, Category = "Vehicle System Plugin|Wheel State")
+	FHitResult GetLastTrace() const
+	{
+		if( bLastTraceDirty )
+		{
+			LastTrace = WheelData.Contact.ToHitResult();
+			bLastTraceDirty = false;
+		}
+		return LastTrace;
+	}
 
 	UFUNCTION(BlueprintPure, Category = "Vehicle System Plugin|Wheel State")
 	EWheelMode GetWheelMode(){ return WheelConfig.WheelMode; }
@@ -333,7 +430,6 @@ public:
 	void SetPassiveMode(bool NewPassive)
 	{
 		if( NewPassive != PassiveMode ) PassiveStateChanged(NewPassive);
-		if( !NewPassive ) { SetComponentTickEnabled(true); }
 		PassiveMode = NewPassive;
 	}
 
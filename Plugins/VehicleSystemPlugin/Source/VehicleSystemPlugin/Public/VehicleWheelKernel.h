@@ -0,0 +1,75 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Tire and suspension math for raycast wheels with a contact, run once the wheel traces are resolved.
+ * Every value is stored in its own float stream (one lane per wheel) so 4 wheels are solved per SIMD register.
+ * Lanes are padded to a multiple of 4 with neutral values, padded results are ignored.
+ */
+struct VEHICLESYSTEMPLUGIN_API FAVS_WheelKernel
+{
+	enum EStream : int32
+	{
+		// Inputs
+		NormalX, NormalY, NormalZ, // Contact normal
+		ForwardX, ForwardY, ForwardZ, // Wheel axes in world space
+		RightX, RightY, RightZ,
+		UpX, UpY, UpZ,
+		VelocityX, VelocityY, VelocityZ, // Wheel velocity at the contact point in world space (cm/s)
+		TraceDistance, // cm
+		Radius, // cm
+		RadiusM, // m
+		SpringLength, // cm
+		SpringStrength, // N/mm
+		SpringDamping, // kNs/m
+		Inertia, // kg*m^2
+		FrictionX, // Tire friction multiplied by the surface friction
+		FrictionY,
+		BrakeTorque, // Nm
+		RollingResistance,
+		BrakeInput, // 0-1, zero for non braking wheels
+		DriveTorque, // Signed input torque, zero for non driving wheels
+		Locked, // 1 when locked by handbrake or isLocked
+		AntiGravity, // Vehicle weight in N * 0.01, added while over compressed
+
+		// Inputs and outputs
+		SlipX,
+		SlipY,
+
+		// Outputs
+		ForceX, ForceY, ForceZ, // Final wheel force (cN)
+		CurrentSpringLength, // cm
+		AngularVelocity, // rad/s
+
+		NumStreams
+	};
+
+	static constexpr int32 LaneWidth = 4;
+	static constexpr float DriveTorqueToNm = 100.0f; // Drive input torque to Nm, the simplified LOD1 tire uses the same scale
+
+	TArray<float, TAlignedHeapAllocator<16>> Streams[NumStreams];
+	TArray<int32> WheelIndex; // Source wheel of each lane
+	int32 NumLanes = 0; // Valid lanes, streams are padded past this
+
+	// Clears all lanes, keeps allocations
+	void Reset();
+
+	// Adds a lane, every input stream has to be written for it, returns the lane index
+	int32 AddLane(int32 InWheelIndex);
+
+	float& Get(EStream Stream, int32 Lane) { return Streams[Stream][Lane]; }
+	float Get(EStream Stream, int32 Lane) const { return Streams[Stream][Lane]; }
+
+	// Solves every lane, uses the vectorized path unless avs.WheelKernel.SIMD is 0
+	void Solve(float DeltaTime);
+
+	void SolveScalar(float DeltaTime);
+	void SolveVectorized(float DeltaTime);
+
+private:
+	void PadLanes();
+};
@@ -0,0 +1,70 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Engine/EngineTypes.h"
+#include "Engine/HitResult.h"
+#include "Chaos/ParticleHandle.h"
+
+class UWorld;
+
+/**
+ * Wheel scene queries for the physics thread.
+ * Rays are gathered for every wheel first, then resolved together in a single pass against the physics scene.
+ * All arrays are flat and indexed by wheel, memory is kept between substeps so steady state does not allocate.
+ */
+struct VEHICLESYSTEMPLUGIN_API FAVS_WheelQueryBatch
+{
+	TArray<FVector> TraceStart;
+	TArray<FVector> TraceEnd;
+	TArray<TEnumAsByte<ECollisionChannel>> TraceChannel;
+	TArray<int32> ParamsIndex; // Index into QueryParams, wheels sharing the same ignore list share params
+	TArray<FHitResult> Hits; // Results, valid after Resolve()
+
+	TArray<FCollisionQueryParams> QueryParams;
+
+	// Clears all queries, keeps allocations
+	void Reset();
+
+	// Creates the query params shared by the wheels of one vehicle, returns the params index
+	int32 AddQueryParams(uint32 IgnoredVehicleId, const TArray<uint32>& IgnoredActorIds);
+
+	// Adds a wheel ray, returns the wheel index in the batch
+	int32 AddQuery(const FVector& Start, const FVector& End, ECollisionChannel Channel, int32 InParamsIndex);
+
+	// Resolves every gathered ray against the world's physics scene, optionally spread over worker threads
+	void Resolve(const UWorld* World, bool bParallel = false);
+
+	int32 Num() const { return TraceStart.Num(); }
+
+	bool HasBlockingHit(int32 Index) const { return Hits[Index].bBlockingHit; }
+};
+
+/**
+ * Last contact of a wheel on a static body.
+ * While the wheel ray barely moves, the new ray is intersected with the cached contact plane instead of tracing again.
+ * Physics thread only, the hit body is checked through its Chaos particle and no UObject is resolved.
+ */
+struct VEHICLESYSTEMPLUGIN_API FAVS_WheelContactCache
+{
+	static constexpr int32 MaxReuses = 32; // Trace again now and then, static geometry can still be streamed out
+
+	FHitResult Hit; // Cached contact, normal and physical material. Location is updated on reuse
+	FVector TraceStart = FVector::ZeroVector; // Ray of the real trace
+	FVector TraceEnd = FVector::ZeroVector;
+	Chaos::FWeakParticleHandle Particle; // Hit particle, cleared by Chaos when the particle is destroyed
+	FTransform ParticleTransform; // Hit particle transform when traced
+	int32 NumReuses = 0;
+	bool bValid = false;
+
+	// Caches a traced hit, only blocking hits on static particles are kept
+	void Store(const FHitResult& Trace);
+
+	void Invalidate() { bValid = false; }
+
+	// Moves the cached hit onto the new ray, false if the ray moved too far and a new trace is needed
+	bool Reproject(const FVector& Start, const FVector& End, float Tolerance);
+};
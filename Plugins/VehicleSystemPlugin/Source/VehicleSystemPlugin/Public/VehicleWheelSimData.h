@@ -0,0 +1,106 @@
+// Copyright 2019-2024 Overtorque Creations LLC. All Rights Reserved.
+// Unauthorized copying of this file, via any medium is strictly prohibited
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+struct FAVS1_Wheel_Config;
+class UPhysicalMaterial;
+
+// Wheel config flags packed for the physics thread
+enum class EAVS_WheelFlags : uint16
+{
+	None			= 0,
+	Driving			= 1 << 0,
+	Steerable		= 1 << 1,
+	InvertTorque	= 1 << 2,
+	InvertSteering	= 1 << 3,
+	Braking			= 1 << 4,
+	Handbrake		= 1 << 5,
+	Locked			= 1 << 6,
+	PhysicsMode		= 1 << 7, // EWheelMode::Physics
+};
+ENUM_CLASS_FLAGS(EAVS_WheelFlags)
+
+/**
+ * Hot wheel data used by the physics thread every substep, structure of arrays indexed by wheel.
+ * Only plain values, rebuilt every game tick into arrays that keep their memory.
+ */
+struct VEHICLESYSTEMPLUGIN_API FAVS_WheelSimData
+{
+	TArray<FTransform> LocalTransform; // Wheel position relative to Vehicle
+	TArray<float> Radius; // cm
+	TArray<float> RadiusM; // m
+	TArray<float> SpringLength; // cm
+	TArray<float> SpringStrength; // N/mm
+	TArray<float> SpringDamping; // kNs/m
+	TArray<float> Inertia; // kg*m^2
+	TArray<float> FrictionX;
+	TArray<float> FrictionY;
+	TArray<float> MaxSteeringAngle; // Degrees
+	TArray<float> BrakeTorque; // Nm
+	TArray<float> RollingResistance;
+	TArray<EAVS_WheelFlags> Flags;
+
+	int32 Num() const { return Flags.Num(); }
+
+	// Clears all wheels, keeps allocations
+	void Reset();
+	void Reserve(int32 NumWheels);
+	void Add(const FAVS1_Wheel_Config& WheelConfig);
+
+	bool HasFlag(int32 WheelIndex, EAVS_WheelFlags Flag) const { return EnumHasAnyFlags(Flags[WheelIndex], Flag); }
+};
+
+// Cold wheel data, only changes when the wheel is edited
+struct FAVS_WheelColdData
+{
+	// Wheel physics body, its physics thread handle is cached per vehicle (see FVehiclePhysicsVehicleState)
+	Chaos::FSingleParticlePhysicsProxy* WheelProxy = nullptr;
+
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECollisionChannel::ECC_Vehicle;
+	TArray<uint32> TraceIgnoreActorIds; // Unique ids, resolved on the game thread so the actors are never touched by the physics thread
+
+	// False when the ignore list matches the previous wheel, so the wheel can share its query params
+	bool bNewQueryParams = true;
+};
+
+/**
+ * Immutable cold data of every simulated wheel of a vehicle.
+ * Built on the game thread when a wheel changes and shared with the physics thread by reference, never copied per tick.
+ */
+struct VEHICLESYSTEMPLUGIN_API FAVS_WheelColdBlock
+{
+	TArray<FAVS_WheelColdData> Wheels;
+
+	void Add(const FAVS1_Wheel_Config& WheelConfig);
+
+	// Cheap hash of the cold fields, used by the game thread to detect when the block has to be rebuilt
+	static uint32 GetColdHash(const FAVS1_Wheel_Config& WheelConfig);
+
+	// Physics proxy of the wheel body, null without one
+	static Chaos::FSingleParticlePhysicsProxy* GetWheelProxy(const FAVS1_Wheel_Config& WheelConfig);
+};
+
+typedef TSharedPtr<const FAVS_WheelColdBlock, ESPMode::ThreadSafe> FAVS_WheelColdBlockPtr;
+
+/**
+ * Friction of the physical materials wheels touched, so the physics thread never resolves a UPhysicalMaterial.
+ * The game thread adds the materials of the wheel outputs, a material is simulated with a friction of 1 until it was added.
+ * Immutable once shared, the game thread replaces the whole table when a material is added or its friction changed.
+ */
+struct FAVS_SurfaceFrictionTable
+{
+	TMap<TWeakObjectPtr<UPhysicalMaterial>, float> Frictions; // Looked up by object index and serial number, the material is not resolved
+
+	float GetFriction(const TWeakObjectPtr<UPhysicalMaterial>& PhysMaterial) const
+	{
+		const float* Friction = Frictions.Find(PhysMaterial);
+		return Friction ? *Friction : 1.0f;
+	}
+};
+
+typedef TSharedPtr<const FAVS_SurfaceFrictionTable, ESPMode::ThreadSafe> FAVS_SurfaceFrictionTablePtr;
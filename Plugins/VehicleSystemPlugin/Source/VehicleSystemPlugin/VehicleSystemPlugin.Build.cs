@@ -15,5 +15,16 @@ public class VehicleSystemPlugin : ModuleRules
 
 		//Required for Chaos physics callbacks
 		SetupModulePhysicsSupport(Target);
+
+		//Telemetry dashboard, RMAImGui is only available on Win64
+		if (Target.Platform == UnrealTargetPlatform.Win64)
+		{
+			PrivateDependencyModuleNames.Add("RMAImGui");
+			PrivateDefinitions.Add("WITH_AVS_IMGUI=1");
+		}
+		else
+		{
+			PrivateDefinitions.Add("WITH_AVS_IMGUI=0");
+		}
 	}
 }